@@ -16,6 +16,7 @@
 
 // Managers
 #include "..\utils\ModelManager.hpp"
+#include "..\Utils\SimulationClock.hpp"
 
 namespace Entities
 {
@@ -40,6 +41,10 @@ namespace Entities
 		 */
 		Vec3 position;
 
+		/** @brief Position before the last simulation tick, drawing is interpolated from it
+		 */
+		Vec3 previousPosition;
+
 		/** @brief Bomb velocity
 		 */
 		Vec3 velocity;
@@ -52,6 +57,10 @@ namespace Entities
 		 */
 		unsigned long safeFrames = 180;
 
+		/** @brief Bomb mesh index
+		 */
+		unsigned short meshIndex;
+
 		/** @brief Bomb mesh
 		 */
 		Objects::Model* mesh;
@@ -69,13 +78,17 @@ namespace Entities
 		Bomb(Vec3& throwDirection, Vec3& position) : position(position), velocity(throwDirection)
 		{
 			this->velocity.z = Fxp::BuildRaw(delta_time) * 15.0;
-			this->mesh = ModelManager::GetModel(6);
+			this->meshIndex = 6;
+			this->mesh = ModelManager::GetModel(this->meshIndex);
+			this->previousPosition = this->position;
 		}
 
 		/** @brief Update bullet
 		 */
 		void Update() override
 		{
+			this->previousPosition = this->position;
+
 			Objects::Terrain::Ground ground;
 			Objects::Terrain::GetGround(this->position, &ground);
 			
@@ -138,14 +151,46 @@ namespace Entities
 			}
 		}
 
+		/** @brief Get bounding sphere of the bomb
+		 * @param center Sphere center
+		 * @param radius Sphere radius
+		 * @return Always true
+		 */
+		bool GetBoundingSphere(Vec3* center, Fxp* radius) override
+		{
+			// Pulsing scale never goes above 1
+			*center = this->position;
+			center->z += 2.0;
+			*radius = this->mesh->GetRadius();
+			return true;
+		}
+
+		/** @brief Get draw layer
+		 * @return Opaque layer
+		 */
+		Layer GetLayer() override
+		{
+			return Layer::Opaque;
+		}
+
+		/** @brief Get material the bomb is drawn with
+		 * @return Model index
+		 */
+		uint16_t GetMaterial() override
+		{
+			return this->meshIndex;
+		}
+
 		/** @brief Draw bullet on screen
 		 */
 		void Draw() override
 		{
+			Vec3 position = SimulationClock::Interpolate(this->previousPosition, this->position);
+
 			Fxp scale = ((Trigonometry::Sin(this->pulse) >> 1) + 1.5) >> 1;
 
 			jo_3d_push_matrix();
-			jo_3d_translate_matrix_fixed(this->position.x.Value(), this->position.y.Value(), (this->position.z + 2.0).Value());
+			jo_3d_translate_matrix_fixed(position.x.Value(), position.y.Value(), (position.z + 2.0).Value());
 			jo_3d_set_scale_fixed(scale.Value(), scale.Value(), scale.Value());
 			this->mesh->Draw();
 			jo_3d_pop_matrix();
@@ -12,6 +12,11 @@
 #include "..\Messages\Damage.hpp"
 #include "..\Messages\QueryController.hpp"
 
+#include "..\Utils\SpriteBatch.hpp"
+#include "..\Utils\JobSystem.hpp"
+#include "..\Utils\SimulationClock.hpp"
+#include "..\Utils\Profiler.hpp"
+
 #include "Explosion.hpp"
 
 namespace Entities
@@ -57,10 +62,86 @@ namespace Entities
 		 */
 		Vec3 position;
 
+		/** @brief Position before the last simulation tick, drawing is interpolated from it
+		 */
+		Vec3 previousPosition;
+
 		/** @brief Bullet velocity 
 		 */
 		Vec3 velocity;
 
+		/** @brief Position after next step, computed ahead by Step()
+		 */
+		Vec3 nextPosition;
+
+		/** @brief Velocity after next step, computed ahead by Step()
+		 */
+		Vec3 nextVelocity;
+
+		/** @brief Indicates whether next step was already computed
+		 */
+		bool stepReady = false;
+
+		/** @brief Bullet hit terrain or static collider in next step
+		 */
+		bool hitStatic = false;
+
+		/** @brief Compute next step of the bullet, reads only shared state so it can run on slave CPU
+		 */
+		void Step()
+		{
+			this->nextVelocity = this->velocity;
+			this->nextPosition = this->position;
+
+			// Update position
+			Vec3 deltaGravity = Bullet::gravity * Fxp::BuildRaw(delta_time);
+			this->nextVelocity += deltaGravity;
+			this->nextPosition += this->nextVelocity * Fxp::BuildRaw(delta_time);
+
+			// Check against terrain
+			Objects::Terrain::Ground ground;
+			Objects::Terrain::GetGround(this->nextPosition, &ground);
+			Fxp groundHeight = ground.Height + Bullet::GroundClearance;
+
+			// Keep the bullet bit above ground, this will also make it roll up small slopes
+			if ((this->nextPosition + deltaGravity).z >= groundHeight && this->nextPosition.z < groundHeight)
+			{
+				this->nextVelocity -= deltaGravity * Fxp::BuildRaw(delta_time);
+				this->nextPosition.z = groundHeight;
+			}
+			else if (this->nextPosition.z < groundHeight)
+			{
+				this->nextVelocity.z = groundHeight - this->nextPosition.z;
+
+				if (this->nextVelocity.z > Bullet::DownForceLimit << 1)
+				{
+					this->nextVelocity = this->nextVelocity * 0.7;
+					this->nextVelocity.z = Bullet::DownForceLimit << 5;
+				}
+
+				this->nextPosition.z = groundHeight;
+			}
+
+			// Check if bullet is already too low or collided with something
+			this->hitStatic = ground.Height > this->nextPosition.z || Objects::Terrain::FindCollision(this->nextPosition, 0, this->nextPosition) != nullptr;
+			this->stepReady = true;
+		}
+
+		/** @brief Step range of bullets
+		 * @param data Bullet list
+		 * @param first First bullet
+		 * @param count Number of bullets
+		 */
+		static void StepJob(void* data, int first, int count)
+		{
+			Bullet** bullets = (Bullet**)data;
+
+			for (int index = first; index < first + count; index++)
+			{
+				bullets[index]->Step();
+			}
+		}
+
 	public:
 		/** @brief Set the Bullet Texture ID
 		 * @param Texture ID
@@ -79,68 +160,88 @@ namespace Entities
 		{
 			this->velocity = this->velocity * Bullet::Speed;
 			this->position.z += Bullet::GroundClearance;
+			this->previousPosition = this->position;
 		}
 		
 		/** @brief Destroy the Bullet
 		 */
 		~Bullet() { }
 		
+		/** @brief Get bounding sphere of the bullet
+		 * @param center Sphere center
+		 * @param radius Sphere radius
+		 * @return Always true
+		 */
+		bool GetBoundingSphere(Vec3* center, Fxp* radius) override
+		{
+			*center = this->position;
+			*radius = Helpers::GetSpriteRadius(Bullet::texture, 0.2);
+			return true;
+		}
+
+		/** @brief Get draw layer
+		 * @return Transparent layer
+		 */
+		Layer GetLayer() override
+		{
+			return Layer::Transparent;
+		}
+
+		/** @brief Get material the bullet is drawn with
+		 * @return Texture index
+		 */
+		uint16_t GetMaterial() override
+		{
+			return Bullet::texture;
+		}
+
+		/** @brief Queue next step of all bullets to be computed on slave CPU
+		 */
+		static void ScheduleJobs()
+		{
+			int count = (int)TrackableObject<Bullet>::objects.size();
+
+			if (count > 0)
+			{
+				JobSystem::Submit(Bullet::StepJob, &TrackableObject<Bullet>::objects[0], 0, count);
+			}
+		}
+
 		/** @brief Draw bullet on screen
 		 */
 		void Draw() override
 		{
-			MATRIX matrix;
+			Vec3 position = SimulationClock::Interpolate(this->previousPosition, this->position);
 
-			jo_3d_push_matrix();
-			jo_3d_translate_matrix_fixed(this->position.x.Value(), this->position.y.Value(), this->position.z.Value());
-			jo_3d_set_scale_fixed(Fxp(0.2).Value(), Fxp(0.2).Value(), Fxp(0.2).Value());
-			Helpers::DrawSprite(Bullet::texture);
-			jo_3d_pop_matrix();
+			SpriteBatch::Add(Bullet::texture, position, 0.2);
 		}
 
 		/** @brief Update bullet
 		 */
 		void Update() override
 		{
+			this->previousPosition = this->position;
+
 			bool destroyBullet = this->lifeTime == 0;
 
 			if (!destroyBullet)
 			{
+				// Terrain part of the step runs in a slave job, only the master side of collision is measured here
+				PROFILE_SCOPE("Collision");
 				this->lifeTime--;
-				
-				// Update position
-				Vec3 deltaGravity = Bullet::gravity * Fxp::BuildRaw(delta_time);
-				this->velocity += deltaGravity;
-				this->position += this->velocity * Fxp::BuildRaw(delta_time);
-
-				// Check against terrain
-				Objects::Terrain::Ground ground;
-				Objects::Terrain::GetGround(this->position, &ground);
-				Fxp groundHeight = ground.Height + Bullet::GroundClearance;
-
-				// Keep the bullet bit above ground, this will also make it roll up small slopes
-				if ((this->position + deltaGravity).z >= groundHeight && this->position.z < groundHeight)
-				{
-					this->velocity -= deltaGravity * Fxp::BuildRaw(delta_time);
-					this->position.z = groundHeight;
-				}
-				else if (this->position.z < groundHeight)
-				{
-					this->velocity.z = groundHeight - this->position.z;
 
-					if (this->velocity.z > Bullet::DownForceLimit << 1)
-					{
-						this->velocity = this->velocity * 0.7;
-						this->velocity.z = Bullet::DownForceLimit << 5;
-					}
-
-					this->position.z = groundHeight;
+				// Step is computed by a job ahead of time, bullets shot this frame are stepped here
+				if (!this->stepReady)
+				{
+					this->Step();
 				}
 
-					// Check if bullet is already too low or collided with something
-					destroyBullet = ground.Height > this->position.z || Objects::Terrain::FindCollision(this->position, 0, this->position) != nullptr;
+				this->position = this->nextPosition;
+				this->velocity = this->nextVelocity;
+				this->stepReady = false;
+				destroyBullet = this->hitStatic;
 
-				// Check against dynamic stuff
+				// Check against dynamic stuff, players move during the tick so this can not be done ahead on slave CPU
 				IColliding* collidesWith = TrackableObject<IColliding>::FirstOrDefault([this](IColliding* item) { return item->Collide(&this->position); });
 
 				if (collidesWith != nullptr)
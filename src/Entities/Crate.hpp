@@ -4,6 +4,7 @@
 
 #include "..\Utils\ponesound\ponesound.hpp"
 #include "Player.hpp"
+#include "..\Utils\SimulationClock.hpp"
 
 namespace Entities
 {
@@ -32,6 +33,10 @@ namespace Entities
 		 */
 		Vec3 position;
 
+		/** @brief Position before the last simulation tick, drawing is interpolated from it
+		 */
+		Vec3 previousPosition;
+
 		/** @brief Time left before spawning 
 		 */
 		Fxp timeToSpawn;
@@ -40,6 +45,10 @@ namespace Entities
 		 */
 		Fxp respawnTime;
 
+		/** @brief Crate model index
+		 */
+		unsigned short modelIndex;
+
 		/** @brief Crate model
 		 */
 		Objects::Model * model;
@@ -96,7 +105,8 @@ namespace Entities
 			this->respawnTime = Fxp::FromInt(respawnTime);
 			this->timeToSpawn = this->respawnTime;
 			this->isOnGround = false;
-			this->model = ModelManager::GetModel(0);
+			this->modelIndex = 0;
+			this->model = ModelManager::GetModel(this->modelIndex);
 			this->position.z = Crate::SpawnHeight;
 			
 			// Get current ground tile
@@ -105,12 +115,15 @@ namespace Entities
 			groundHeight = ground.Height;
 
 			this->rotation = Trigonometry::RadiansToSgl(Fxp::FromInt(jo_random(6)));
+			this->previousPosition = this->position;
 		}
 
 		/** @brief Make entity think
 		 */
 		void Update() override
 		{
+			this->previousPosition = this->position;
+
 			if (this->isOnGround)
 			{
 				Player* collidesWith = TrackableObject<Player>::FirstOrDefault([this](Player* item) { return item->Collide(&this->collider); });
@@ -143,6 +156,7 @@ namespace Entities
 						this->isOnGround = false;
 						this->timeToSpawn = this->respawnTime;
 						this->position.z = Crate::SpawnHeight;
+						this->previousPosition = this->position;
 						this->rotation = Trigonometry::RadiansToSgl(Fxp::FromInt(jo_random(6)));
 						PoneSound::Sound::Play(3, PoneSound::PlayMode::Semi, 5);
 					}
@@ -176,14 +190,44 @@ namespace Entities
 			}
 		}
 
+		/** @brief Get bounding sphere of the crate
+		 * @param center Sphere center
+		 * @param radius Sphere radius
+		 * @return Always true
+		 */
+		bool GetBoundingSphere(Vec3* center, Fxp* radius) override
+		{
+			*center = this->position;
+			*radius = this->model->GetRadius();
+			return true;
+		}
+
+		/** @brief Get draw layer
+		 * @return Opaque layer
+		 */
+		Layer GetLayer() override
+		{
+			return Layer::Opaque;
+		}
+
+		/** @brief Get material the crate is drawn with
+		 * @return Model index
+		 */
+		uint16_t GetMaterial() override
+		{
+			return this->modelIndex;
+		}
+
 		/** @brief Render world
 		 */
 		void Draw() override
 		{
+			Vec3 position = SimulationClock::Interpolate(this->previousPosition, this->position);
+
 			if (this->timeToSpawn <= 0.0)
 			{
 				jo_3d_push_matrix();
-				jo_3d_translate_matrix_fixed(this->position.x.Value(), this->position.y.Value(), this->position.z.Value());
+				jo_3d_translate_matrix_fixed(position.x.Value(), position.y.Value(), position.z.Value());
 				slRotZ(this->rotation);
 
 				if (this->isOnGround)
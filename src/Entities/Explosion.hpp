@@ -5,7 +5,9 @@
 #include "..\Utils\Math\Vec3.hpp"
 #include "..\Interfaces\IRenderable.hpp"
 #include "..\Interfaces\IUpdatable.hpp"
+#include "..\Utils\FrameGovernor.hpp"
 #include "..\Utils\Helpers.hpp"
+#include "..\Utils\SpriteBatch.hpp"
 
 namespace Entities
 {
@@ -81,17 +83,44 @@ namespace Entities
 			this->passedTime += Fxp::BuildRaw(delta_time);
 		}
 		
+		/** @brief Get bounding sphere of the explosion
+		 * @param center Sphere center
+		 * @param radius Sphere radius
+		 * @return Always true
+		 */
+		bool GetBoundingSphere(Vec3* center, Fxp* radius) override
+		{
+			*center = this->position;
+			*radius = Helpers::GetSpriteRadius(Explosion::texture + this->frame, this->scale);
+			return true;
+		}
+
+		/** @brief Get draw layer
+		 * @return Transparent layer
+		 */
+		Layer GetLayer() override
+		{
+			return Layer::Transparent;
+		}
+
+		/** @brief Get material the explosion is drawn with
+		 * @return Texture index
+		 */
+		uint16_t GetMaterial() override
+		{
+			return Explosion::texture + this->frame;
+		}
+
 		/** @brief Draw bullet on screen
 		 */
 		void Draw() override
 		{
-			jo_3d_push_matrix();
-			jo_3d_translate_matrix_fixed(this->position.x.Value(), this->position.y.Value(), this->position.z.Value());
-			jo_3d_set_scale_fixed(this->scale.Value(), this->scale.Value(), this->scale.Value());
-			
-			Helpers::DrawSprite(Explosion::texture + this->frame);
+			if (!FrameGovernor::IsEnabled(FrameGovernor::Feature::Explosions))
+			{
+				return;
+			}
 
-			jo_3d_pop_matrix();
+			SpriteBatch::Add(Explosion::texture + this->frame, this->position, this->scale);
 		}
 	};
 	
@@ -11,6 +11,7 @@
 #include "..\Messages\Damage.hpp"
 #include "..\Messages\QueryController.hpp"
 #include "..\Utils\Helpers.hpp"
+#include "..\Utils\SpriteBatch.hpp"
 
 namespace Entities
 {
@@ -110,17 +111,40 @@ namespace Entities
 			}
 		}
 
+		/** @brief Get bounding sphere of the mine
+		 * @param center Sphere center
+		 * @param radius Sphere radius
+		 * @return Always true
+		 */
+		bool GetBoundingSphere(Vec3* center, Fxp* radius) override
+		{
+			*center = this->position;
+			center->z += 1.0;
+			*radius = Helpers::GetSpriteRadius(Mine::texture, 0.2);
+			return true;
+		}
+
+		/** @brief Get draw layer
+		 * @return Transparent layer
+		 */
+		Layer GetLayer() override
+		{
+			return Layer::Transparent;
+		}
+
+		/** @brief Get material the mine is drawn with
+		 * @return Texture index
+		 */
+		uint16_t GetMaterial() override
+		{
+			return Mine::texture;
+		}
+
 		/** @brief Draw bullet on screen
 		 */
 		void Draw() override
 		{
-			MATRIX matrix;
-
-			jo_3d_push_matrix();
-			jo_3d_translate_matrix_fixed(this->position.x.Value(), this->position.y.Value(), (this->position.z + 1.0).Value());
-			jo_3d_set_scale_fixed(Fxp(0.2).Value(), Fxp(0.2).Value(), Fxp(0.2).Value());
-			Helpers::DrawSprite(Mine::texture);
-			jo_3d_pop_matrix();
+			SpriteBatch::Add(Mine::texture, Vec3(this->position.x, this->position.y, this->position.z + 1.0), 0.2);
 		}
 	};
 }
\ No newline at end of file
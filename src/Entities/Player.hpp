@@ -19,6 +19,8 @@
 #include "..\Messages\QueryController.hpp"
 
 #include "..\Utils\Helpers.hpp"
+#include "..\Utils\SimulationClock.hpp"
+#include "..\Utils\Profiler.hpp"
 
 namespace Entities
 {
@@ -63,6 +65,10 @@ namespace Entities
 		 */
 		int16_t health = Player::MaxHealth;
 
+		/** @brief Model index of the detail
+		 */
+		unsigned short modelIndex;
+
 		/** @brief Model of the detail
 		 */
 		Objects::Model* model;
@@ -71,6 +77,10 @@ namespace Entities
 		 */
 		Vec3 position;
 
+		/** @brief Position before the last simulation tick, drawing is interpolated from it
+		 */
+		Vec3 previousPosition;
+
 		/** @brief How much time is left before player can shoot again
 		 */
 		uint8_t shootCoolDownTimeLeft;
@@ -245,7 +255,12 @@ namespace Entities
 				}
 				
 				// Find static colliders
-				AABB* staticCollision = Objects::Terrain::FindCollision(this->position, 2, this);
+				AABB* staticCollision = nullptr;
+
+				{
+					PROFILE_SCOPE("Collision");
+					staticCollision = Objects::Terrain::FindCollision(this->position, 2, this);
+				}
 
 				// On static collision just move back
 				if (staticCollision != nullptr)
@@ -273,7 +288,9 @@ namespace Entities
 		Player(const Vec3& position, Fxp angle, uint8_t controller) : position(position), angle(angle), controller(controller)
 		{
 			this->shootCoolDownTimeLeft = 0;
-			this->model = ModelManager::GetModel(1);
+			this->modelIndex = 1;
+			this->model = ModelManager::GetModel(this->modelIndex);
+			this->previousPosition = this->position;
 		}
 
 		/** @brief Get the Health
@@ -283,6 +300,13 @@ namespace Entities
 			return this->health;
 		}
 
+		/** @brief Get player position
+		 */
+		const Vec3& GetPosition()
+		{
+			return this->position;
+		}
+
 		/** @brief Get player controller
 		 */
 		int GetController()
@@ -350,6 +374,8 @@ namespace Entities
 		 */
 		void Update() override
 		{
+			this->previousPosition = this->position;
+
 			// Handle shoot cool down
 			if (this->shootCoolDownTimeLeft > 0)
 			{
@@ -372,13 +398,45 @@ namespace Entities
 			UI::HudHandler.HandleMessages(playerUpdate);
 		}
 
+		/** @brief Get bounding sphere of the player
+		 * @param center Sphere center
+		 * @param radius Sphere radius
+		 * @return Always true
+		 */
+		bool GetBoundingSphere(Vec3* center, Fxp* radius) override
+		{
+			// Head sprite sits above the body, all frames have same size
+			Fxp head = Helpers::GetSpriteRadius(Player::CharacterSpiteStart, 0.4);
+			*center = this->position;
+			*radius = (this->model->GetRadius() > head ? this->model->GetRadius() : head) + 5.0;
+			return true;
+		}
+
+		/** @brief Get draw layer
+		 * @return Opaque layer
+		 */
+		Layer GetLayer() override
+		{
+			return Layer::Opaque;
+		}
+
+		/** @brief Get material the player is drawn with
+		 * @return Model index
+		 */
+		uint16_t GetMaterial() override
+		{
+			return this->modelIndex;
+		}
+
 		/** @brief Draw detail
 		 */
 		void Draw() override
 		{
+			Vec3 position = SimulationClock::Interpolate(this->previousPosition, this->position);
+
 			// Draw body
 			jo_3d_push_matrix();
-			jo_3d_translate_matrix_fixed(this->position.x.Value(), this->position.y.Value(), (this->position.z + 1.0).Value());
+			jo_3d_translate_matrix_fixed(position.x.Value(), position.y.Value(), (position.z + 1.0).Value());
 			slRotZ(Trigonometry::RadiansToSgl(this->angle));
 
 			this->model->Draw(1);
@@ -392,7 +450,7 @@ namespace Entities
 
 			// Draw head
 			jo_3d_push_matrix();
-			jo_3d_translate_matrix_fixed(this->position.x.Value(), (this->position.y - 1.0).Value(), (this->position.z + 4.0).Value());
+			jo_3d_translate_matrix_fixed(position.x.Value(), (position.y - 1.0).Value(), (position.z + 4.0).Value());
 			Fxp mirror = 0.4;
 
 			int index = (this->health > 0) ? this->controller : 4;
@@ -23,9 +23,13 @@ namespace Entities
 		 */
 		unsigned short model;
 
-		/** @brief SGL angle
+		/** @brief Loaded model, resolved once at spawn
 		 */
-		ANGLE Angle;
+		Objects::Model* modelData;
+
+		/** @brief Local to world transformation, baked at spawn since detail never moves
+		 */
+		MATRIX transform;
 
 	public:
 
@@ -36,11 +40,62 @@ namespace Entities
 		 */
 		StaticDetail3D(const Vec3& position, Fxp angle, unsigned short model) : Position(position), model(model)
 		{ 
-			this->Angle = Trigonometry::RadiansToSgl(angle);
+			this->modelData = ModelManager::GetModel(this->model);
+
+			StaticDetail3D::PushTransform(this->Position, angle);
+			slGetMatrix(this->transform);
+			slPopMatrix();
+
+			StaticDetail3D::AddCollider(this->Position);
+		}
+
+		/** @brief Push new matrix with local to world transformation of a detail, must be popped by caller
+		 * @param position Position in the scene
+		 * @param angle Detail rotation in radians
+		 */
+		static void PushTransform(const Vec3& position, Fxp angle)
+		{
+			// Let SGL build the matrix on a unit stack level, so it matches translate and rotate done while drawing
+			slPushUnitMatrix();
+			slTranslate(position.x.Value(), position.y.Value(), position.z.Value());
+			slRotZ(Trigonometry::RadiansToSgl(angle));
+		}
+
+		/** @brief Set collider of a detail on its ground tile
+		 * @param position Position in the scene
+		 */
+		static void AddCollider(const Vec3& position)
+		{
 			static Fxp size = 3.0;
+			Objects::Terrain::SetGroundCollider(position, new AABB(position, Vec3(size, size, size << 2)));
+		}
+
+		/** @brief Get bounding sphere of the detail
+		 * @param center Sphere center
+		 * @param radius Sphere radius
+		 * @return Always true
+		 */
+		bool GetBoundingSphere(Vec3* center, Fxp* radius) override
+		{
+			*center = this->Position;
+			*radius = this->modelData->GetRadius();
+			return true;
+		}
 
-			// Get current ground tile
-			Objects::Terrain::SetGroundCollider(this->Position, new AABB(this->Position, Vec3(size, size, size << 2)));
+		/** @brief Get draw layer
+		 * @return Opaque layer
+		 */
+		Layer GetLayer() override
+		{
+			return Layer::Opaque;
+		}
+
+		/** @brief Get material the detail is drawn with
+		 * @return Model index
+		 */
+		uint16_t GetMaterial() override
+		{
+			return this->model;
 		}
 
 		/** @brief Draw detail
@@ -48,9 +103,8 @@ namespace Entities
 		void Draw() override
 		{
 			jo_3d_push_matrix();
-			jo_3d_translate_matrix_fixed(this->Position.x.Value(), this->Position.y.Value(), this->Position.z.Value());
-			slRotZ(this->Angle);
-			ModelManager::GetModel(this->model)->Draw();
+			slMultiMatrix(this->transform);
+			this->modelData->Draw();
 			jo_3d_pop_matrix();
 		}
 	};
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <jo/Jo.hpp>
+
+#include "..\Objects\Map.hpp"
+#include "..\Objects\Mesh3D.hpp"
+#include "..\Utils\FrameGovernor.hpp"
+#include "..\Utils\ModelManager.hpp"
+#include "..\Utils\RenderStats.hpp"
+#include "StaticModel.hpp"
+
+namespace Entities
+{
+	/** @brief Static map props merged into one world space mesh per terrain chunk
+	 * @details Props never move, so their meshes are transformed once at load and each chunk is drawn with a single
+	 * submission under the world matrix. Props that can not be merged are left to be spawned as StaticDetail3D.
+	 */
+	struct StaticProps
+	{
+	private:
+		/** @brief Number of chunks props are grouped into
+		 */
+		static const int ChunkCount = Objects::LevelFormat::ChunksPerSide * Objects::LevelFormat::ChunksPerSide;
+
+		/** @brief Most points a single chunk can hold, keeps one submission well within SGL vertex buffer
+		 */
+		static const int MaxChunkPoints = 1024;
+
+		/** @brief All merged prop geometry, stored chunk after chunk
+		 */
+		Objects::Mesh3D mesh;
+
+		/** @brief Merged props of each chunk, point into mesh
+		 */
+		PDATA chunks[StaticProps::ChunkCount];
+
+		/** @brief Get chunk prop is placed in
+		 * @param location Prop location
+		 * @return Chunk index or -1 if outside of the map
+		 */
+		static int GetChunk(const Vec3& location)
+		{
+			// Tile is 8 units wide
+			int x = location.x.Value() >> 19;
+			int y = location.y.Value() >> 19;
+
+			if (x < 0 || y < 0 || x >= Objects::Map::MapDimensionSize || y >= Objects::Map::MapDimensionSize)
+			{
+				return -1;
+			}
+
+			return (x / Objects::LevelFormat::ChunkSize) + ((y / Objects::LevelFormat::ChunkSize) * Objects::LevelFormat::ChunksPerSide);
+		}
+
+		/** @brief Transform model into world space and append it to its chunk
+		 * @param model Prop model
+		 * @param entity Prop definition
+		 * @param chunk Chunk to append to
+		 */
+		void Append(Objects::Model* model, const Objects::Map::EntityCreationDefinition& entity, PDATA& chunk)
+		{
+			Entities::StaticDetail3D::PushTransform(entity.Location, entity.Angle);
+
+			for (size_t meshIndex = 0; meshIndex < model->GetMeshCount(); meshIndex++)
+			{
+				// Merged props are drawn at full detail
+				if (model->IsLowerLevel(meshIndex))
+				{
+					continue;
+				}
+
+				const Objects::Mesh3D* source = model->GetMesh(meshIndex);
+				uint16_t firstPoint = chunk.nbPoint;
+
+				for (size_t point = 0; point < source->nbPoint; point++)
+				{
+					slCalcPoint(source->pntbl[point][X], source->pntbl[point][Y], source->pntbl[point][Z], chunk.pntbl[chunk.nbPoint++]);
+				}
+
+				for (size_t polygon = 0; polygon < source->nbPolygon; polygon++)
+				{
+					POLYGON& target = chunk.pltbl[chunk.nbPolygon];
+					slCalcVector((FIXED*)source->pltbl[polygon].norm, target.norm);
+
+					for (int vertex = 0; vertex < 4; vertex++)
+					{
+						target.Vertices[vertex] = source->pltbl[polygon].Vertices[vertex] + firstPoint;
+					}
+
+					chunk.attbl[chunk.nbPolygon++] = source->attbl[polygon];
+				}
+			}
+
+			slPopMatrix();
+		}
+
+	public:
+		/** @brief Merge prop entities of the map, merged entities are replaced with empty ones
+		 * @param map Loaded map
+		 */
+		StaticProps(Objects::Map* map)
+		{
+			uint16_t points[StaticProps::ChunkCount] = { 0 };
+			uint16_t polygons[StaticProps::ChunkCount] = { 0 };
+			int8_t* targets = new int8_t[JO_MAX(map->EntityDefinitionsCount, 1)];
+
+			// Count geometry of each chunk
+			for (int index = 0; index < map->EntityDefinitionsCount; index++)
+			{
+				const Objects::Map::EntityCreationDefinition& entity = map->EntityDefinitions[index];
+				Objects::Model* model = ModelManager::GetModel(entity.Reserved[1]);
+				int chunk = StaticProps::GetChunk(entity.Location);
+				targets[index] = -1;
+
+				if (entity.Type != Objects::Map::EntityType::Model || model == nullptr || chunk < 0)
+				{
+					continue;
+				}
+
+				size_t modelPoints = 0;
+				size_t modelPolygons = 0;
+
+				for (size_t meshIndex = 0; meshIndex < model->GetMeshCount(); meshIndex++)
+				{
+					if (model->IsLowerLevel(meshIndex))
+					{
+						continue;
+					}
+
+					modelPoints += model->GetMesh(meshIndex)->nbPoint;
+					modelPolygons += model->GetMesh(meshIndex)->nbPolygon;
+				}
+
+				// Full chunk keeps the prop as separate entity
+				if (points[chunk] + modelPoints <= StaticProps::MaxChunkPoints)
+				{
+					points[chunk] += modelPoints;
+					polygons[chunk] += modelPolygons;
+					targets[index] = chunk;
+				}
+			}
+
+			size_t pointCount = 0;
+			size_t polygonCount = 0;
+
+			for (int chunk = 0; chunk < StaticProps::ChunkCount; chunk++)
+			{
+				pointCount += points[chunk];
+				polygonCount += polygons[chunk];
+			}
+
+			if (polygonCount > 0)
+			{
+				this->mesh = Objects::Mesh3D(pointCount, polygonCount);
+			}
+
+			// Lay chunks out one after another, counts grow back as props are appended
+			pointCount = 0;
+			polygonCount = 0;
+
+			for (int chunk = 0; chunk < StaticProps::ChunkCount; chunk++)
+			{
+				this->chunks[chunk].pntbl = this->mesh.pntbl + pointCount;
+				this->chunks[chunk].nbPoint = 0;
+				this->chunks[chunk].pltbl = this->mesh.pltbl + polygonCount;
+				this->chunks[chunk].nbPolygon = 0;
+				this->chunks[chunk].attbl = this->mesh.attbl + polygonCount;
+				pointCount += points[chunk];
+				polygonCount += polygons[chunk];
+			}
+
+			for (int index = 0; index < map->EntityDefinitionsCount; index++)
+			{
+				if (targets[index] < 0)
+				{
+					continue;
+				}
+
+				Objects::Map::EntityCreationDefinition& entity = map->EntityDefinitions[index];
+				this->Append(ModelManager::GetModel(entity.Reserved[1]), entity, this->chunks[targets[index]]);
+				Entities::StaticDetail3D::AddCollider(entity.Location);
+
+				// Nothing left to spawn
+				entity.Type = Objects::Map::EntityType::Empty;
+			}
+
+			delete[] targets;
+		}
+
+		/** @brief Draw props of all chunks, must be called with world matrix set after map was drawn
+		 * @param map Map props are placed on
+		 */
+		void Draw(const Objects::Map* map)
+		{
+			bool drawFar = FrameGovernor::IsEnabled(FrameGovernor::Feature::FarProps);
+
+			for (int index = 0; index < StaticProps::ChunkCount; index++)
+			{
+				PDATA& chunk = this->chunks[index];
+
+				if (chunk.nbPolygon > 0 && (drawFar || !map->IsChunkDrawnFar(index)))
+				{
+					RenderStats::AddPolygons(chunk.nbPolygon);
+					slPutPolygon(&chunk);
+				}
+			}
+		}
+	};
+}
@@ -16,6 +16,7 @@
 
 // Spawnable entities
 #include "StaticModel.hpp"
+#include "StaticProps.hpp"
 #include "Player.hpp"
 #include "Crate.hpp"
 #include "Explosion.hpp"
@@ -31,73 +32,394 @@ namespace Entities
 	struct World : public IRenderable, TrackableObject<Entities::World>
 	{
 	private:
+		/** @brief Stage loading phases, each one is done over one or more frames
+		 */
+		enum class LoadPhase
+		{
+			/** @brief Waiting for the map file to be read from CD
+			 */
+			ReadFile,
+
+			/** @brief Building map mesh from the loaded file
+			 */
+			BuildGeometry,
+
+			/** @brief Merging static props into terrain chunks
+			 */
+			MergeProps,
+
+			/** @brief Spawning map entities
+			 */
+			SpawnEntities,
+
+			/** @brief Waiting for terrain around players to be streamed in
+			 */
+			StreamTerrain,
+
+			/** @brief Stage is ready to be played
+			 */
+			Done,
+
+			/** @brief Map file could not be read, stage can not be played
+			 */
+			Failed
+		};
+
+		/** @brief Number of entities spawned in a single frame
+		 */
+		static const int EntitiesPerFrame = 8;
+
+		/** @brief Number of frames map file read is retried while file system queue is full
+		 */
+		static const int ReadRetryFrames = 120;
+
+		/** @brief World waiting for its map file to be read
+		 */
+		inline static World* pendingRead = nullptr;
+
+		/** @brief Number of started map file reads, token of the newest one
+		 */
+		inline static int readCount = 0;
+
 		/** @brief Index of first ground texture
 		 */
 		int groundTextures = 0;
 
+		/** @brief Current loading phase
+		 */
+		LoadPhase phase;
+
+		/** @brief Loaded map file
+		 */
+		char* stream;
+
+		/** @brief Static props merged per terrain chunk
+		 */
+		Entities::StaticProps* props;
+
+		/** @brief Number of already spawned entities
+		 */
+		int spawned;
+
+		/** @brief Player contorller
+		 */
+		uint8_t controller;
+
+		/** @brief Chunk pack of the map, empty if map has none
+		 */
+		char chunkFile[16];
+
+		/** @brief Map file name
+		 */
+		const char* file;
+
+		/** @brief Frames map file read could not be started
+		 */
+		int readRetries;
+
+		/** @brief Start reading map file in the background
+		 * @return True if read was queued
+		 */
+		bool StartRead()
+		{
+			if (!jo_fs_read_file_async(this->file, World::FileLoaded, ++World::readCount))
+			{
+				return false;
+			}
+
+			World::pendingRead = this;
+			return true;
+		}
+
+		/** @brief Map file read finished
+		 * @param contents File contents
+		 * @param length File length
+		 * @param token Read number
+		 */
+		static void FileLoaded(char* contents, int length, int token)
+		{
+			// Read of a destroyed world can still be queued when the next one starts its own
+			if (World::pendingRead != nullptr && token == World::readCount)
+			{
+				World* world = World::pendingRead;
+				World::pendingRead = nullptr;
+
+				// Failed read has no data, too short file has no map
+				if (length < (int)sizeof(Objects::LevelFormat::LevelData))
+				{
+					jo_free(contents);
+					world->phase = LoadPhase::Failed;
+					return;
+				}
+
+				world->stream = contents;
+			}
+			else
+			{
+				// World was destroyed before read finished
+				jo_free(contents);
+			}
+		}
+
+		/** @brief Focus terrain streaming on region all players are in
+		 */
+		void UpdateTerrainFocus()
+		{
+			if (TrackableObject<Entities::Player>::objects.empty())
+			{
+				this->Map->SetFocus(0, 0, Objects::Map::MapDimensionSize - 1, Objects::Map::MapDimensionSize - 1);
+				return;
+			}
+
+			int fromX = Objects::Map::MapDimensionSize;
+			int fromY = Objects::Map::MapDimensionSize;
+			int toX = 0;
+			int toY = 0;
+
+			for (auto* object : TrackableObject<Entities::Player>::objects)
+			{
+				// Tile is 8 units wide
+				const Vec3& position = object->GetPosition();
+				int x = JO_MIN(JO_MAX(position.x.Value() >> 19, 0), Objects::Map::MapDimensionSize - 1);
+				int y = JO_MIN(JO_MAX(position.y.Value() >> 19, 0), Objects::Map::MapDimensionSize - 1);
+				fromX = JO_MIN(fromX, x);
+				fromY = JO_MIN(fromY, y);
+				toX = JO_MAX(toX, x);
+				toY = JO_MAX(toY, y);
+			}
+
+			this->Map->SetFocus(fromX, fromY, toX, toY);
+		}
+
+		/** @brief Spawn single map entity
+		 * @param entity Entity definition
+		 */
+		void SpawnEntity(const Objects::Map::EntityCreationDefinition& entity)
+		{
+			switch (entity.Type)
+			{
+			case Objects::Map::EntityType::PlayerSpawn:
+
+				// We can spawn 12 players at most
+				if (this->controller < JO_INPUT_MAX_DEVICE && this->controller < Settings::PlayerCount)
+				{
+					new Entities::Player(entity.Location, entity.Angle, this->controller++);
+				}
+
+				break;
+
+			case Objects::Map::EntityType::Model:
+				new Entities::StaticDetail3D(entity.Location, entity.Angle, (unsigned short)entity.Reserved[1]);
+				break;
+
+			case Objects::Map::EntityType::Crate:
+				new Entities::Crate(entity.Location, (unsigned char)entity.Reserved[0], (unsigned short)entity.Reserved[1]);
+				break;
+
+			default:
+				break;
+			}
+		}
+
 	public:
 		/** @brief Map definition
 		 */
 		Objects::Map* Map;
 
-		/** @brief Initializes a new instance of the World and populates it with entities
+		/** @brief Initializes a new instance of the World, map file is read in the background
 		 * @param name Name of the map file on the CD
 		 */
-		World(const char* name)
+		World(const char* name) : phase(LoadPhase::ReadFile), stream(nullptr), props(nullptr), spawned(0), controller(0), file(name), readRetries(0), Map(nullptr)
 		{
-			// Load map file
-			this->Map = new Objects::Map(name, Objects::Terrain::FirstGroundTextureIndex);
-			Objects::Terrain::Map = this->Map;
-			Objects::Terrain::ClearColliders();
+			// Terrain is streamed if there is a chunk pack next to the map file (FOO.UTE -> FOO.UTC)
+			strncpy(this->chunkFile, name, sizeof(this->chunkFile) - 1);
+			this->chunkFile[sizeof(this->chunkFile) - 1] = '\0';
+			size_t length = strlen(this->chunkFile);
 
-			// Player contorller
-			uint8_t controller = 0;
+			if (length > 0)
+			{
+				this->chunkFile[length - 1] = 'C';
+			}
 
-			// Start spawning entities
-			for (int i = 0; i < this->Map->EntityDefinitionsCount; i++)
+			if (length == 0 || GFS_NameToId((Sint8*)this->chunkFile) < 0)
 			{
-				Objects::Map::EntityCreationDefinition entity = this->Map->EntityDefinitions[i];
+				this->chunkFile[0] = '\0';
+			}
 
-				switch (entity.Type)
-				{
-				case Objects::Map::EntityType::PlayerSpawn:
+			// Read is retried while loading if file system is busy
+			if (!this->StartRead())
+			{
+				this->readRetries++;
+			}
+		}
+
+		/** @brief Destroy the World object
+		 */
+		~World()
+		{
+			if (World::pendingRead == this)
+			{
+				World::pendingRead = nullptr;
+			}
+
+			if (this->stream != nullptr)
+			{
+				jo_free(this->stream);
+			}
+
+			delete this->props;
+			delete this->Map;
+		}
+
+		/** @brief Check whether stage is ready to be played
+		 * @return True if loaded
+		 */
+		bool IsLoaded()
+		{
+			return this->phase == LoadPhase::Done;
+		}
+
+		/** @brief Check whether stage could not be loaded
+		 * @return True if loading failed
+		 */
+		bool HasFailed()
+		{
+			return this->phase == LoadPhase::Failed;
+		}
+
+		/** @brief Get loading progress
+		 * @return Progress in percent
+		 */
+		int GetLoadProgress()
+		{
+			switch (this->phase)
+			{
+			case LoadPhase::ReadFile:
+				return 0;
+
+			case LoadPhase::BuildGeometry:
+				return 50;
+
+			case LoadPhase::MergeProps:
+				return 55;
+
+			case LoadPhase::SpawnEntities:
+				return 60 + ((30 * this->spawned) / JO_MAX(this->Map->EntityDefinitionsCount, 1));
+
+			case LoadPhase::StreamTerrain:
+				return 90;
 
-					// We can spawn 12 players at most
-					if (controller < JO_INPUT_MAX_DEVICE && controller < Settings::PlayerCount)
+			default:
+				return 100;
+			}
+		}
+
+		/** @brief Do next step of stage loading, should be called once per frame until stage is loaded
+		 * @return True if loaded
+		 */
+		bool Load()
+		{
+			switch (this->phase)
+			{
+			case LoadPhase::ReadFile:
+				if (this->stream != nullptr)
+				{
+					this->phase = LoadPhase::BuildGeometry;
+				}
+				else if (this->readRetries > 0 && !this->StartRead())
+				{
+					// Queue stays full or file is missing
+					if (++this->readRetries > World::ReadRetryFrames)
 					{
-						new Entities::Player(entity.Location, entity.Angle, controller++);
+						this->phase = LoadPhase::Failed;
 					}
+				}
+				else
+				{
+					this->readRetries = 0;
+				}
+
+				break;
 
-					break;
+			case LoadPhase::BuildGeometry:
+				this->Map = new Objects::Map(
+					this->stream,
+					Objects::Terrain::FirstGroundTextureIndex,
+					this->chunkFile[0] != '\0' ? this->chunkFile : nullptr);
+				jo_free(this->stream);
+				this->stream = nullptr;
 
-				case Objects::Map::EntityType::Model:
-					new Entities::StaticDetail3D(entity.Location, entity.Angle, (unsigned short)entity.Reserved[1]);
-					break;
+				Objects::Terrain::Map = this->Map;
+				Objects::Terrain::ClearColliders();
+				this->phase = LoadPhase::MergeProps;
+				break;
 
-				case Objects::Map::EntityType::Crate:
-					new Entities::Crate(entity.Location, (unsigned char)entity.Reserved[0], (unsigned short)entity.Reserved[1]);
-					break;
+			case LoadPhase::MergeProps:
+				this->props = new Entities::StaticProps(this->Map);
+				this->phase = LoadPhase::SpawnEntities;
+				break;
 
-				default:
-					break;
+			case LoadPhase::SpawnEntities:
+				for (int i = 0; i < World::EntitiesPerFrame && this->spawned < this->Map->EntityDefinitionsCount; i++)
+				{
+					this->SpawnEntity(this->Map->EntityDefinitions[this->spawned++]);
 				}
+
+				if (this->spawned >= this->Map->EntityDefinitionsCount)
+				{
+					this->phase = LoadPhase::StreamTerrain;
+				}
+
+				break;
+
+			case LoadPhase::StreamTerrain:
+				if (this->Map->IsStreaming())
+				{
+					this->UpdateTerrainFocus();
+					this->Map->UpdateStreaming();
+				}
+
+				if (this->Map->IsFocusResident())
+				{
+					jo_clear_screen();
+					this->phase = LoadPhase::Done;
+				}
+
+				break;
+
+			default:
+				break;
 			}
 
-			jo_clear_screen();
+			return this->phase == LoadPhase::Done;
 		}
 
-		/** @brief Destroy the World object
+		/** @brief Get draw layer
+		 * @return World layer
 		 */
-		~World()
+		Layer GetLayer() override
 		{
-			delete this->Map;
+			return Layer::World;
 		}
 
 		/** @brief Render world
 		 */
 		void Draw()
 		{
-			this->Map->Draw();
+			if (this->Map != nullptr)
+			{
+				if (this->Map->IsStreaming())
+				{
+					this->UpdateTerrainFocus();
+				}
+
+				this->Map->Draw();
+			}
+
+			if (this->props != nullptr && this->Map != nullptr)
+			{
+				this->props->Draw(this->Map);
+			}
 		}
 	};
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "..\Utils\TrackableObject.hpp"  // Include necessary header for TrackableObject
+#include "..\Utils\Math\Vec3.hpp"
 
 /**
  * @brief Interface for renderable objects.
@@ -9,10 +10,44 @@
  */
 struct IRenderable : public TrackableObject<IRenderable>
 {
+    /**
+     * @brief Draw layers, lower layers are submitted first.
+     */
+    enum class Layer : uint8_t
+    {
+        World = 0,       /**< Terrain and other things everything else is drawn on. */
+        Opaque = 1,      /**< Models. */
+        Transparent = 2, /**< Sprites with transparent pixels. */
+        Overlay = 3      /**< Things drawn over the scene. */
+    };
+
     /**
      * @brief Virtual function for rendering the object.
      * 
      * Derived classes should implement this function to define the rendering behavior.
      */
     virtual void Draw() {}
+
+    /**
+     * @brief Get sphere enclosing everything the object draws, used to skip objects outside of the view.
+     * 
+     * @param center Sphere center in world space.
+     * @param radius Sphere radius.
+     * @return False if object has no bounds and must be always drawn.
+     */
+    virtual bool GetBoundingSphere(Vec3* center, Fxp* radius) { return false; }
+
+    /**
+     * @brief Get layer the object is drawn in.
+     * 
+     * @return Draw layer.
+     */
+    virtual Layer GetLayer() { return Layer::Opaque; }
+
+    /**
+     * @brief Get model or texture the object is drawn with, objects with same material and depth are submitted together.
+     * 
+     * @return Material index.
+     */
+    virtual uint16_t GetMaterial() { return 0; }
 };
@@ -15,4 +15,33 @@ struct IUpdatable : public TrackableObject<IUpdatable>
      * Derived classes should implement this function to define the updating behavior.
      */
     virtual void Update() {}
+
+    /**
+     * @brief Updates all objects once.
+     *
+     * Indexed, objects spawned during update grow the list and may move it, they are first updated next tick.
+     * Objects may delete themselves or others during update, which shifts the rest of the list down,
+     * so the index only moves on when the object at it is still the one just updated.
+     */
+    static void UpdateAll()
+    {
+        size_t count = objects.size();
+        size_t index = 0;
+
+        while (index < count && index < objects.size())
+        {
+            IUpdatable* current = objects[index];
+            current->Update();
+
+            if (index < objects.size() && objects[index] == current)
+            {
+                index++;
+            }
+            else
+            {
+                // Removed object was at or before index, next one is now at index
+                count--;
+            }
+        }
+    }
 };
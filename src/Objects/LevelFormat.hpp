@@ -0,0 +1,175 @@
+#pragma once
+
+#include <stdint.h>
+
+/** @brief Game objects
+ */
+namespace Objects
+{
+	/** @brief Layout of the UTE level file, shared by the game and host tools
+	 * @note File is big-endian, fixed point values are 16.16
+	 */
+	namespace LevelFormat
+	{
+		/** @brief Size of the map
+		 */
+		static const int MapDimensionSize = 20;
+
+		/** @brief Number of tiles in the map
+		 */
+		static const int TileCount = LevelFormat::MapDimensionSize * LevelFormat::MapDimensionSize;
+
+		/** @brief Fixed point vector as saved within a file
+		 */
+		struct Vector
+		{
+			/** @brief X coordinate
+			 */
+			int32_t X;
+
+			/** @brief Y coordinate
+			 */
+			int32_t Y;
+
+			/** @brief Z coordinate
+			 */
+			int32_t Z;
+		};
+
+		/** @brief Level tile
+		 */
+		struct Tile
+		{
+			/** @brief Depth and rotation are present in a single byte
+			 */
+			unsigned char Rotation : 2;
+
+			/** @brief Depth and rotation are present in a single byte
+			 */
+			unsigned char Depth : 6;
+
+			/** @brief Index of a texture to use
+			 */
+			unsigned char Texture;
+
+			/** @brief Unused space
+			 */
+			unsigned short Dummy;
+		};
+
+		/** @brief Gouraud table entry
+		 */
+		struct GouraudColor
+		{
+			/** @brief Vertex color
+			 */
+			uint16_t Colors[4];
+		};
+
+		/** @brief Base entity definition as saved within a file
+		 */
+		struct EntityDefinition
+		{
+			/** @brief Entity type to spawn
+			 */
+			int32_t Type;
+
+			/** @brief X coordinate of tile to spawn entity on
+			 */
+			unsigned short TileX;
+
+			/** @brief Y coordinate of tile to spawn entity on
+			 */
+			unsigned short TileY;
+
+			/** @brief Direction in radians
+			 */
+			int32_t Direction;
+
+			/** @brief Unused space
+			 */
+			unsigned char Dummy[16];
+		};
+
+		/** @brief Light data
+		 */
+		struct Light
+		{
+			/** @brief Light direction
+			 */
+			Vector Direction;
+
+			/** @brief Light color
+			 */
+			uint16_t Color;
+
+			/** @brief Unused space
+			 */
+			short Dummy;
+		};
+
+		/** @brief Level file data
+		 */
+		struct LevelData
+		{
+			/** @brief File identifier (should read 'UTE' and 4th byte indicates version)
+			 */
+			unsigned char Identifier[4];
+
+			/** @brief Map tiles
+			 */
+			Tile TileData[LevelFormat::TileCount];
+
+			/** @brief Level sun
+			 */
+			Light Sun;
+
+			/** @brief Precalculated gouraud table
+			 */
+			GouraudColor Gouraud[LevelFormat::TileCount];
+
+			/** @brief Precalculated face normals
+			 */
+			Vector Normals[LevelFormat::TileCount];
+
+			/** @brief Number of entities in the following block
+			 */
+			uint32_t EntityCount;
+		};
+
+		/** @brief Number of tiles along one side of a terrain chunk
+		 */
+		static const int ChunkSize = 4;
+
+		/** @brief Number of terrain chunks along one side of the map
+		 */
+		static const int ChunksPerSide = LevelFormat::MapDimensionSize / LevelFormat::ChunkSize;
+
+		/** @brief Size of a single chunk in a chunk pack, each chunk takes one CD sector
+		 */
+		static const int ChunkSectorSize = 2048;
+
+		/** @brief Full detail data of a terrain chunk, chunk pack (.UTC) holds one per sector ordered by chunk index
+		 */
+		struct ChunkData
+		{
+			/** @brief Chunk tiles, row after row
+			 */
+			Tile TileData[LevelFormat::ChunkSize * LevelFormat::ChunkSize];
+
+			/** @brief Precalculated face normals, row after row
+			 */
+			Vector Normals[LevelFormat::ChunkSize * LevelFormat::ChunkSize];
+
+			/** @brief Vertex heights, row after row
+			 */
+			int32_t Heights[(LevelFormat::ChunkSize + 1) * (LevelFormat::ChunkSize + 1)];
+		};
+
+		static_assert(sizeof(Tile) == 4, "Tile must be 4 bytes");
+		static_assert(sizeof(EntityDefinition) == 28, "Entity definition must be 28 bytes");
+		static_assert(sizeof(Light) == 16, "Light must be 16 bytes");
+		static_assert(sizeof(LevelData) == 9624, "Level header must be 9624 bytes");
+		static_assert(sizeof(ChunkData) <= ChunkSectorSize, "Chunk must fit into a single sector");
+	}
+}
@@ -2,7 +2,11 @@
 
 #include <jo\Jo.hpp>
 #include "Mesh3D.hpp"
+#include "LevelFormat.hpp"
 #include "..\utils\LoaderUtil.hpp"
+#include "..\Utils\PakTextureLoader.hpp"
+#include "..\Utils\FrameGovernor.hpp"
+#include "..\Utils\RenderStats.hpp"
 #include "..\utils\std\vector.h"
 #include "..\Interfaces\IColliding.hpp"
 
@@ -18,122 +22,325 @@ namespace Objects
 
 		/** @brief Size of the map
 		 */
-		static const int MapDimensionSize = 20;
+		static const int MapDimensionSize = LevelFormat::MapDimensionSize;
 
 	private:
 		/** @brief Index of first color in gouraud table
 		 */
 		static const int GouraudTableStart = JO_VDP1_VRAM + 0x70000;
 
-		/** @brief Level tile
+		/** @brief Number of tiles in the map
 		 */
-		struct Tile
-		{
-			/** @brief Depth and rotation are present in a single byte
-			 */
-			unsigned char Rotation : 2;
+		static const int TileCount = LevelFormat::TileCount;
 
-			/** @brief Depth and rotation are present in a single byte
-			 */
-			unsigned char Depth : 6;
+		/** @brief Maximal number of tiles relit in a single frame
+		 */
+		static const int RelightTilesPerFrame = 40;
 
-			/** @brief Index of a texture to use
-			 */
-			unsigned char Texture;
+		/** @brief Number of tiles along one side of a render chunk
+		 */
+		static const int ChunkSize = LevelFormat::ChunkSize;
 
-			/** @brief Unused space
-			 */
-			unsigned short Dummy;
-		};
+		/** @brief Number of render chunks along one side of the map
+		 */
+		static const int ChunksPerSide = LevelFormat::ChunksPerSide;
+
+		/** @brief Number of render chunks
+		 */
+		static const int ChunkCount = Map::ChunksPerSide * Map::ChunksPerSide;
+
+		static_assert(Map::ChunkCount <= 32, "Chunk masks hold 32 chunks at most");
+
+		/** @brief Number of tiles in a render chunk
+		 */
+		static const int ChunkTileCount = Map::ChunkSize * Map::ChunkSize;
+
+		/** @brief Number of points in a render chunk, border points are not shared between chunks
+		 */
+		static const int ChunkPointCount = (Map::ChunkSize + 1) * (Map::ChunkSize + 1);
+
+		/** @brief Number of tiles along one side of a far chunk, each far tile covers 2x2 tiles
+		 */
+		static const int FarChunkSize = Map::ChunkSize >> 1;
+
+		/** @brief Number of merged tiles in a far chunk
+		 */
+		static const int FarChunkTileCount = Map::FarChunkSize * Map::FarChunkSize;
+
+		/** @brief Number of points in a far chunk
+		 */
+		static const int FarChunkPointCount = (Map::FarChunkSize + 1) * (Map::FarChunkSize + 1);
+
+		/** @brief View depth at which chunk switches to far representation
+		 */
+		static const jo_fixed FarChunkDistance = 256 << 16;
+
+		/** @brief View depth at which far chunk switches back to full detail
+		 */
+		static const jo_fixed NearChunkDistance = 224 << 16;
+
+		/** @brief Maximal number of full detail chunks kept in memory when terrain is streamed
+		 */
+		static const int MaxResidentChunks = 9;
+
+		/** @brief Number of chunks around focused region that are prefetched when terrain is streamed
+		 */
+		static const int PrefetchRing = 1;
+
+		/** @brief Map that streams its terrain
+		 */
+		inline static Map* streamingMap = nullptr;
+
+		/** @brief Chunk sectors are read here, static so a read in flight never outlives it
+		 */
+		alignas(4) inline static char chunkBuffer[LevelFormat::ChunkSectorSize + 1];
+
+		/** @brief Level tile
+		 */
+		using Tile = LevelFormat::Tile;
 
 		/** @brief Gouraud table entry
 		 */
-		struct GouraudColor
-		{
-			/** @brief Vertex color
-			 */
-			jo_color Colors[4];
-		};
+		using GouraudColor = LevelFormat::GouraudColor;
 
 		/** @brief Base entity definition as saved within a file
 		 */
-		struct EntityDefinition
-		{
-			/** @brief Entity type to spawn
-			 */
-			int Type;
+		using EntityDefinition = LevelFormat::EntityDefinition;
 
-			/** @brief X coordinate of tile to spawn entity on
-			 */
-			unsigned short TileX;
+		/** @brief Level file data
+		 */
+		using LevelData = LevelFormat::LevelData;
 
-			/** @brief Y coordinate of tile to spawn entity on
-			 */
-			unsigned short TileY;
+		/** @brief Streamed chunk data
+		 */
+		using ChunkData = LevelFormat::ChunkData;
 
-			/** @brief Direction in radians
-			 */
-			Fxp Direction;
+		/** @brief 3D mesh of the map, stored chunk slot after chunk slot
+		 */
+		Mesh3D mapMesh;
 
-			/** @brief Unused space
-			 */
-			unsigned char Dummy[16];
-		};
+		/** @brief Untextured flat shaded mesh with merged tiles used for distant chunks, stored chunk after chunk
+		 */
+		Mesh3D farMesh;
 
-		/** @brief Light data
+		/** @brief Full detail chunks, point into map mesh
 		 */
-		struct Light
-		{
-			/** @brief Light direction
-			 */
-			Vec3 Direction;
+		PDATA nearChunks[Map::ChunkCount];
 
-			/** @brief Light color
-			 */
-			jo_color Color;
+		/** @brief Cheap chunks, point into far mesh
+		 */
+		PDATA farChunks[Map::ChunkCount];
 
-			/** @brief Unused space
-			 */
-			short Dummy;
-		};
+		/** @brief Chunks currently drawn with far representation, one bit per chunk
+		 */
+		uint32_t farChunkMask;
 
-		/** @brief Level file data
+		/** @brief Chunks that need their far colors recalculated, one bit per chunk
 		 */
-		struct LevelData
-		{
-			/** @brief File identifier (should read 'UTE' and 4th byte indicates version)
-			 */
-			unsigned char Identifier[4];
+		uint32_t staleFarChunks;
 
-			/** @brief Map tiles
-			 */
-			Tile TileData[Map::MapDimensionSize * Map::MapDimensionSize];
+		/** @brief Chunk pack terrain is streamed from, empty if whole map is resident
+		 */
+		char chunkFile[16];
 
-			/** @brief Level sun
-			 */
-			Light Sun;
+		/** @brief Number of full detail chunk slots in map mesh
+		 */
+		int slotCount;
 
-			/** @brief Precalculated gouraud table
-			 */
-			GouraudColor Gouraud[Map::MapDimensionSize * Map::MapDimensionSize];
+		/** @brief Slot holding full detail of each chunk, -1 if chunk is not resident
+		 */
+		int8_t chunkSlots[Map::ChunkCount];
 
-			/** @brief Precalculated face normals
-			 */
-			Vec3 Normals[Map::MapDimensionSize * Map::MapDimensionSize];
+		/** @brief Chunk held by each slot, -1 if slot is free
+		 */
+		int8_t slotChunks[Map::ChunkCount];
 
-			/** @brief Number of entities in the following block
-			 */
-			size_t EntityCount;
-		};
+		/** @brief Frame each slot was last used, least recently used slot is reused first
+		 */
+		uint32_t slotLastUse[Map::ChunkCount];
 
-		/** @brief 3D mesh of the map
+		/** @brief Chunk being read from the CD, -1 if none
 		 */
-		Mesh3D mapMesh;
+		int loadingChunk;
+
+		/** @brief Chunks within and around focused region, one bit per chunk
+		 */
+		uint32_t wantedChunks;
+
+		/** @brief Chunk in the middle of focused region
+		 */
+		int focusX, focusY;
+
+		/** @brief Number of streaming updates done
+		 */
+		uint32_t frame;
 
 		/** @brief List of tile heights for each tile
 		 */
 		jo_fixed tileHeights[Map::MapDimensionSize * Map::MapDimensionSize];
 
+		/** @brief Texture of each tile
+		 */
+		uint16_t tileTextures[Map::TileCount];
+
+		/** @brief Normal of each tile, kept for the whole map so collisions never depend on what is streamed in
+		 */
+		Vec3 tileNormals[Map::TileCount];
+
+		/** @brief Rotation of each tile, decides which polygon vertex each gouraud color lands on
+		 */
+		uint8_t tileRotations[Map::TileCount];
+
+		/** @brief Baked light minus light calculated from tile normals at each vertex
+		 * @details Level baker smooths terrain more than averaged tile normals do, relit tiles keep that detail this way
+		 * and a tile relit under the baked sun gets exactly its baked colors back.
+		 */
+		Fxp vertexLightBias[(Map::MapDimensionSize + 1) * (Map::MapDimensionSize + 1)];
+
+		/** @brief Gouraud table kept in work RAM, vertex colors are already in the order VDP1 expects
+		 */
+		jo_color gouraudTable[Map::TileCount][4];
+
+		/** @brief Tiles waiting to be relit, one bit per tile
+		 */
+		uint32_t dirtyTiles[(Map::TileCount + 31) >> 5];
+
+		/** @brief Number of tiles waiting to be relit
+		 */
+		int dirtyTileCount;
+
+		/** @brief Upload part of the gouraud table to VDP1
+		 * @param first First tile to upload
+		 * @param last Last tile to upload
+		 */
+		void UploadGouraud(const size_t first, const size_t last)
+		{
+			slDMACopy(
+				this->gouraudTable[first],
+				(void*)(Map::GouraudTableStart + JO_MULT_BY_8(first)),
+				(last - first + 1) * sizeof(this->gouraudTable[0]));
+		}
+
+		/** @brief Get tile corner a gouraud color belongs to
+		 * @details Level file keeps colors by tile corner, VDP1 takes them in polygon vertex order and FillChunk rotates
+		 * polygon vertices by tile rotation.
+		 * @param rotation Tile rotation
+		 * @param slot Color index in the order VDP1 expects
+		 * @return Corner in level file order, (x, y), (x, y + 1), (x + 1, y + 1) and (x + 1, y)
+		 */
+		static int GetGouraudCorner(const int rotation, const int slot)
+		{
+			return 3 - ((slot + 1 + rotation) & 3);
+		}
+
+		/** @brief Get vertex location of a tile corner
+		 * @param tile Tile index
+		 * @param corner Corner in level file order
+		 * @param x Vertex X location
+		 * @param y Vertex Y location
+		 */
+		static void GetCornerVertex(const size_t tile, const int corner, int* x, int* y)
+		{
+			static const int offsets[4][2] = { { 0, 0 }, { 0, 1 }, { 1, 1 }, { 1, 0 } };
+			*x = (tile % Map::MapDimensionSize) + offsets[corner][0];
+			*y = (tile / Map::MapDimensionSize) + offsets[corner][1];
+		}
+
+		/** @brief Get light intensity at vertex, normal is averaged from all neighboring tiles
+		 * @param x Vertex X location
+		 * @param y Vertex Y location
+		 * @return Light intensity in range 0 to 1
+		 */
+		Fxp GetVertexLight(const int x, const int y)
+		{
+			Vec3 normal;
+
+			for (int tileY = y - 1; tileY <= y; tileY++)
+			{
+				for (int tileX = x - 1; tileX <= x; tileX++)
+				{
+					if (tileX >= 0 && tileX < Map::MapDimensionSize &&
+						tileY >= 0 && tileY < Map::MapDimensionSize)
+					{
+						normal += this->GetTileNormal(tileX, tileY);
+					}
+				}
+			}
+
+			Fxp length = normal.Length();
+
+			if (length == 0.0)
+			{
+				return 0.0;
+			}
+
+			Fxp intensity = -this->Light.Direction.Dot(normal / length);
+			return Fxp::Min(Fxp::Max(intensity, 0.0), 1.0);
+		}
+
+		/** @brief Shade sun color by light intensity
+		 * @param intensity Light intensity
+		 * @return Gouraud color
+		 */
+		jo_color ShadeColor(const Fxp& intensity)
+		{
+			return JO_COLOR_SATURN_RGB(
+				(Fxp::FromInt(JO_COLOR_SATURN_GET_R(this->Light.Color)) * intensity).Value() >> 16,
+				(Fxp::FromInt(JO_COLOR_SATURN_GET_G(this->Light.Color)) * intensity).Value() >> 16,
+				(Fxp::FromInt(JO_COLOR_SATURN_GET_B(this->Light.Color)) * intensity).Value() >> 16);
+		}
+
+		/** @brief Recalculate gouraud colors of a single tile
+		 * @param tile Tile index
+		 */
+		void RelightTile(const size_t tile)
+		{
+			for (int slot = 0; slot < 4; slot++)
+			{
+				int x;
+				int y;
+				Map::GetCornerVertex(tile, Map::GetGouraudCorner(this->tileRotations[tile], slot), &x, &y);
+
+				Fxp intensity = this->GetVertexLight(x, y) + this->vertexLightBias[Map::GetVertexIndex(x, y)];
+				this->gouraudTable[tile][slot] = this->ShadeColor(Fxp::Min(Fxp::Max(intensity, 0.0), 1.0));
+			}
+		}
+
+		/** @brief Remember how baked light differs from light calculated from tile normals
+		 * @param level Level data
+		 */
+		void MeasureLightBias(const LevelData* level)
+		{
+			// Brightest channel of the sun loses least precision
+			int sun = JO_MAX(JO_MAX(JO_COLOR_SATURN_GET_R(this->Light.Color), JO_COLOR_SATURN_GET_G(this->Light.Color)), JO_COLOR_SATURN_GET_B(this->Light.Color));
+			int shift = sun == JO_COLOR_SATURN_GET_R(this->Light.Color) ? 0 : (sun == JO_COLOR_SATURN_GET_G(this->Light.Color) ? 5 : 10);
+
+			for (Fxp& bias : this->vertexLightBias)
+			{
+				bias = 0.0;
+			}
+
+			if (sun == 0)
+			{
+				return;
+			}
+
+			for (size_t tile = 0; tile < Map::TileCount; tile++)
+			{
+				for (int corner = 0; corner < 4; corner++)
+				{
+					int x;
+					int y;
+					Map::GetCornerVertex(tile, corner, &x, &y);
+
+					// Baked color was rounded down, middle of its step gives it back when shaded again
+					int baked = (level->Gouraud[tile].Colors[corner] >> shift) & 0x1f;
+					Fxp intensity = (Fxp::FromInt(baked) + 0.5) / Fxp::FromInt(sun);
+					this->vertexLightBias[Map::GetVertexIndex(x, y)] = intensity - this->GetVertexLight(x, y);
+				}
+			}
+		}
+
 		/** @brief Get vertex index from location
 		 * @param x X location
 		 * @param y Y location
@@ -144,6 +351,65 @@ namespace Objects
 			return x + (y * (Map::MapDimensionSize + 1));
 		}
 
+		/** @brief Get tile normal
+		 * @param x X location
+		 * @param y Y location
+		 * @return Tile normal
+		 */
+		const Vec3& GetTileNormal(const int x, const int y)
+		{
+			return this->tileNormals[Map::GetTileIndex(x, y)];
+		}
+
+		/** @brief Get vertex index within a chunk
+		 * @param x X location within the chunk
+		 * @param y Y location within the chunk
+		 * @param size Number of tiles along chunk side
+		 * @return Vertex index
+		 */
+		constexpr static size_t GetChunkVertexIndex(const size_t& x, const size_t& y, const size_t& size)
+		{
+			return x + (y * (size + 1));
+		}
+
+		/** @brief Fill full detail chunk slot
+		 * @param slot Slot in map mesh
+		 * @param chunk Chunk index
+		 * @param tiles Chunk tiles, row after row
+		 * @param normals Tile normals, row after row
+		 * @param heights Chunk vertex heights, row after row
+		 */
+		void FillChunk(const int slot, const int chunk, const Tile* tiles, const Vec3* normals, const jo_fixed* heights);
+
+		/** @brief Build far representation of a chunk
+		 * @param chunk Chunk index
+		 * @param heights Vertex heights of the whole map
+		 * @param normals Tile normals of the whole map
+		 */
+		void BuildFarChunk(const int chunk, const jo_fixed* heights, const LevelFormat::Vector* normals);
+
+		/** @brief Pick next chunk to read from the CD and a slot for it
+		 */
+		void RequestChunk();
+
+		/** @brief Chunk sector was read
+		 * @param contents Chunk data
+		 * @param length Data length
+		 * @param token Chunk index
+		 */
+		static void ChunkRead(char* contents, int length, int token);
+
+		/** @brief Recalculate flat colors of a far chunk from texture colors and gouraud table
+		 * @param chunk Chunk index
+		 */
+		void UpdateFarColors(const int chunk);
+
+		/** @brief Decide whether chunk should be drawn with far representation
+		 * @param chunk Chunk index
+		 * @return True if chunk is far from camera
+		 */
+		bool IsChunkFar(const int chunk);
+
 		/** @brief Get the Tile vertex heights
 		 * @param data Level data
 		 * @param x Tile X coordinate
@@ -209,6 +475,10 @@ namespace Objects
 			jo_color Color;
 		};
 
+		/** @brief Draw distant chunks with cheaper untextured geometry
+		 */
+		inline static bool LodEnabled = true;
+
 		int EntityDefinitionsCount;
 
 		/** @brief Entities to be created on the map
@@ -229,7 +499,12 @@ namespace Objects
 			return x + (y * Map::MapDimensionSize);
 		}
 
-		Map(const char* file, int firstTerrainTexture);
+		/** @brief Initializes a new instance of the Map class
+		 * @param stream Loaded map file contents, caller keeps ownership
+		 * @param firstTerrainTexture Index of first terrain texture
+		 * @param chunkFile Chunk pack to stream full detail terrain from, whole terrain is kept in memory if null
+		 */
+		Map(char* stream, int firstTerrainTexture, const char* chunkFile = nullptr);
 
 		/** @brief Frees all resources and destroys the isntance
 		 */
@@ -239,6 +514,57 @@ namespace Objects
 		 */
 		void Draw();
 
+		/** @brief Change level sun, all tiles will be relit over the next few frames
+		 * @param direction Light direction
+		 * @param color Light color
+		 */
+		void SetSun(const Vec3& direction, jo_color color);
+
+		/** @brief Mark tiles around location for relighting
+		 * @param x Tile X location
+		 * @param y Tile Y location
+		 * @param radius Radius in number of tiles (1, would be an area 3x3)
+		 */
+		void InvalidateLighting(int x, int y, int radius);
+
+		/** @brief Relight dirty tiles and upload changed part of the gouraud table
+		 */
+		void UpdateLighting();
+
+		/** @brief Check whether terrain is streamed from the CD
+		 * @return True if streamed
+		 */
+		bool IsStreaming()
+		{
+			return this->chunkFile[0] != '\0';
+		}
+
+		/** @brief Check whether chunk was drawn with far representation in last Draw()
+		 * @param chunk Chunk index
+		 * @return True if drawn with far representation
+		 */
+		bool IsChunkDrawnFar(const int chunk) const
+		{
+			return (Map::LodEnabled && (this->farChunkMask & ((uint32_t)1 << chunk)) != 0) || this->chunkSlots[chunk] < 0;
+		}
+
+		/** @brief Set region full detail terrain is needed in, chunks around it are prefetched
+		 * @param fromX First tile X location
+		 * @param fromY First tile Y location
+		 * @param toX Last tile X location
+		 * @param toY Last tile Y location
+		 */
+		void SetFocus(int fromX, int fromY, int toX, int toY);
+
+		/** @brief Check whether all chunks of focused region are resident
+		 * @return True if resident
+		 */
+		bool IsFocusResident();
+
+		/** @brief Start reading next missing chunk, called by Draw() each frame
+		 */
+		void UpdateStreaming();
+
 		/** @brief Get information about specific tile
 		 * @param x Tile X location
 		 * @param y Tile Y location
@@ -252,60 +578,83 @@ namespace Objects
 		{
 			int index = Map::GetTileIndex(x, y);
 			*height = Fxp::BuildRaw(this->tileHeights[index]);
-			*material = this->mapMesh.attbl[index].texno;
-
-			*normal = Vec3(
-				Fxp::BuildRaw(this->mapMesh.pltbl[index].norm[X]),
-				Fxp::BuildRaw(this->mapMesh.pltbl[index].norm[Y]),
-				Fxp::BuildRaw(this->mapMesh.pltbl[index].norm[Z]));
+			*material = this->tileTextures[index];
+			*normal = this->GetTileNormal(x, y);
 
 			return index;
 		}
 	};
 
 	/** @brief Initializes a new instance of the Map class
-	 * @param file Map file name
+	 * @param stream Loaded map file contents, caller keeps ownership
 	 * @param firstTerrainTexture Index of first terrain texture
+	 * @param chunkFile Chunk pack to stream full detail terrain from, whole terrain is kept in memory if null
 	 */
-	Map::Map(const char* file, int firstTerrainTexture)
+	Map::Map(char* stream, int firstTerrainTexture, const char* chunkFile)
 	{
 		// Load level data
-		char* stream = jo_fs_read_file_in_dir(file, JO_ROOT_DIR, NULL);
-		char* streamStart = stream;
 		LevelData* level = GetAndIterate<LevelData>(stream);
 
-		// Initialize mesh
-		this->mapMesh = Mesh3D((Map::MapDimensionSize + 1) * (Map::MapDimensionSize + 1), Map::MapDimensionSize * Map::MapDimensionSize);
+		// Streamed terrain keeps only few chunks in memory
+		this->chunkFile[0] = '\0';
+		this->slotCount = Map::ChunkCount;
+
+		if (chunkFile != nullptr)
+		{
+			strncpy(this->chunkFile, chunkFile, sizeof(this->chunkFile) - 1);
+			this->chunkFile[sizeof(this->chunkFile) - 1] = '\0';
+			this->slotCount = Map::MaxResidentChunks;
+			Map::streamingMap = this;
+		}
+
+		for (int chunk = 0; chunk < Map::ChunkCount; chunk++)
+		{
+			this->chunkSlots[chunk] = -1;
+			this->slotChunks[chunk] = -1;
+			this->slotLastUse[chunk] = 0;
+		}
+
+		this->loadingChunk = -1;
+		this->wantedChunks = 0;
+		this->focusX = 0;
+		this->focusY = 0;
+		this->frame = 0;
 
-		this->Light.Direction = level->Sun.Direction;
+		// Initialize meshes
+		this->mapMesh = Mesh3D(this->slotCount * Map::ChunkPointCount, this->slotCount * Map::ChunkTileCount);
+		this->farMesh = Mesh3D(Map::ChunkCount * Map::FarChunkPointCount, Map::ChunkCount * Map::FarChunkTileCount);
+
+		this->Light.Direction = (const Vec3&)level->Sun.Direction;
 		this->Light.Color = level->Sun.Color;
 
 		Vec3 vector = -Light.Direction;
 		slLight((FIXED*)&vector);
 
-		// Load gouraud
-		for (uint32_t color = 0; color < this->mapMesh.nbPolygon; color++)
+		// Load gouraud, colors follow polygon vertices around rotated tiles
+		for (uint32_t color = 0; color < Map::TileCount; color++)
 		{
-			jo_color* ptr = (jo_color*)(JO_VDP1_VRAM + 0x70000 + JO_MULT_BY_8(color));
-			*ptr = level->Gouraud[color].Colors[2];
-			*(ptr + 1) = level->Gouraud[color].Colors[1];
-			*(ptr + 2) = level->Gouraud[color].Colors[0];
-			*(ptr + 3) = level->Gouraud[color].Colors[3];
-		}
+			this->tileRotations[color] = level->TileData[color].Rotation;
 
-		// Reset point data
-		for (size_t x = 0; x <= Map::MapDimensionSize; x++)
-		{
-			for (size_t y = 0; y <= Map::MapDimensionSize; y++)
+			for (int slot = 0; slot < 4; slot++)
 			{
-				int index = Map::GetVertexIndex(x, y);
-				this->mapMesh.pntbl[index][X] = ((x) << 19);
-				this->mapMesh.pntbl[index][Y] = ((y) << 19);
-				this->mapMesh.pntbl[index][Z] = 0;
+				this->gouraudTable[color][slot] = level->Gouraud[color].Colors[Map::GetGouraudCorner(this->tileRotations[color], slot)];
 			}
 		}
 
-		// Load tile geometry
+		this->UploadGouraud(0, Map::TileCount - 1);
+
+		// Baked lighting is up to date
+		this->dirtyTileCount = 0;
+
+		for (uint32_t& mask : this->dirtyTiles)
+		{
+			mask = 0;
+		}
+
+		// Vertex heights of the whole map, chunks get their own copy of border vertices
+		jo_fixed* vertexHeights = new jo_fixed[(Map::MapDimensionSize + 1) * (Map::MapDimensionSize + 1)];
+
+		// Load tile heights
 		for (size_t tileY = 0; tileY < Map::MapDimensionSize; tileY++)
 		{
 			for (size_t tileX = 0; tileX < Map::MapDimensionSize; tileX++)
@@ -316,9 +665,8 @@ namespace Objects
 
 				// Get tile location in array
 				size_t currentTile = Map::GetTileIndex(tileX, tileY);
-
-				// // Set polygon
-				(Vec3&)mapMesh.pltbl[currentTile].norm = level->Normals[currentTile];
+				this->tileTextures[currentTile] = firstTerrainTexture + level->TileData[currentTile].Texture;
+				this->tileNormals[currentTile] = (const Vec3&)level->Normals[currentTile];
 
 				// Set vertex indicies
 				size_t vertices[4] = {
@@ -340,38 +688,54 @@ namespace Objects
 				int depth = (depths[0] + depths[1] + depths[2] + depths[3]) / 4;
 				this->tileHeights[currentTile] = depth;
 
-				// TODO: support tile rotation
-				int baseIndex = 3 - level->TileData[currentTile].Rotation;
-
 				for (size_t vertex = 0; vertex < 4; vertex++)
 				{
-					if (baseIndex >= 4)
-					{
-						baseIndex = 0;
-					}
-
-					this->mapMesh.pntbl[vertices[vertex]][Z] = depthsRotated[vertex];
-					this->mapMesh.pltbl[currentTile].Vertices[baseIndex] = vertices[vertex];
-					baseIndex++;
+					vertexHeights[vertices[vertex]] = depthsRotated[vertex];
 				}
+			}
+		}
 
-				// Set attribute
-				ATTR attribute = ATTRIBUTE(
-					Dual_Plane,
-					SORT_MAX,
-					(uint16_t)(firstTerrainTexture + level->TileData[currentTile].Texture),
-					JO_COLOR_White,
-					CL32KRGB | No_Gouraud,
-					CL32KRGB | MESHoff,
-					sprHVflip,
-					No_Option);
+		this->MeasureLightBias(level);
 
-				attribute.gstb = 0xe000 + currentTile;
-				JO_ADD_FLAG(attribute.atrb, CL_Gouraud);
-				this->mapMesh.attbl[currentTile] = attribute;
+		// Split map into chunks
+		for (int chunk = 0; chunk < Map::ChunkCount; chunk++)
+		{
+			this->BuildFarChunk(chunk, vertexHeights, level->Normals);
+
+			if (this->IsStreaming())
+			{
+				// Full detail is read from the chunk pack when needed
+				continue;
 			}
+
+			Tile tiles[Map::ChunkTileCount];
+			Vec3 normals[Map::ChunkTileCount];
+			jo_fixed heights[Map::ChunkPointCount];
+			int firstX = (chunk % Map::ChunksPerSide) * Map::ChunkSize;
+			int firstY = (chunk / Map::ChunksPerSide) * Map::ChunkSize;
+
+			for (int y = 0; y <= Map::ChunkSize; y++)
+			{
+				for (int x = 0; x <= Map::ChunkSize; x++)
+				{
+					heights[Map::GetChunkVertexIndex(x, y, Map::ChunkSize)] = vertexHeights[Map::GetVertexIndex(firstX + x, firstY + y)];
+
+					if (x < Map::ChunkSize && y < Map::ChunkSize)
+					{
+						size_t tile = Map::GetTileIndex(firstX + x, firstY + y);
+						tiles[x + (y * Map::ChunkSize)] = level->TileData[tile];
+						normals[x + (y * Map::ChunkSize)] = (const Vec3&)level->Normals[tile];
+					}
+				}
+			}
+
+			this->FillChunk(chunk, chunk, tiles, normals, heights);
 		}
 
+		delete[] vertexHeights;
+		this->farChunkMask = 0;
+		this->staleFarChunks = 0;
+
 		// Load entities to spawn
 		EntityDefinitionsCount = level->EntityCount;
 		this->EntityDefinitions = new EntityCreationDefinition[level->EntityCount];
@@ -389,23 +753,553 @@ namespace Objects
 						(Fxp::FromInt(entityPtr->TileY) + 0.5) << 3,
 						Fxp::BuildRaw(depth)
 					),
-					entityPtr->Direction,
+					Fxp::BuildRaw(entityPtr->Direction),
 					{ entityPtr->Dummy[0], entityPtr->Dummy[1] }
 				);
 		}
-
-		jo_free(streamStart);
 	}
 
 	/** @brief Frees all resources and destroys the isntance
 	 */
-	Map::~Map() {}
+	Map::~Map()
+	{
+		// Gouraud table might still be in transfer
+		slDMAWait();
+
+		// Chunk read in flight will be thrown away
+		if (Map::streamingMap == this)
+		{
+			Map::streamingMap = nullptr;
+		}
+	}
 
 	/** @brief Draw map
 	 */
 	void Map::Draw()
 	{
-		jo_3d_mesh_draw(this->mapMesh.JoPtr());
+		if (this->IsStreaming())
+		{
+			this->UpdateStreaming();
+		}
+
+		if (this->dirtyTileCount > 0)
+		{
+			this->UpdateLighting();
+		}
+
+		if (this->staleFarChunks != 0)
+		{
+			for (int chunk = 0; chunk < Map::ChunkCount; chunk++)
+			{
+				if ((this->staleFarChunks & ((uint32_t)1 << chunk)) != 0)
+				{
+					this->UpdateFarColors(chunk);
+				}
+			}
+
+			this->staleFarChunks = 0;
+		}
+
+		for (int chunk = 0; chunk < Map::ChunkCount; chunk++)
+		{
+			int slot = this->chunkSlots[chunk];
+
+			// Chunks that are not resident yet are always drawn with far representation
+			if ((Map::LodEnabled && this->IsChunkFar(chunk)) || slot < 0)
+			{
+				RenderStats::AddPolygons(this->farChunks[chunk].nbPolygon);
+				slPutPolygon(&this->farChunks[chunk]);
+			}
+			else
+			{
+				this->slotLastUse[slot] = this->frame;
+				RenderStats::AddPolygons(this->nearChunks[chunk].nbPolygon);
+				slPutPolygon(&this->nearChunks[chunk]);
+			}
+		}
+	}
+
+	/** @brief Fill full detail chunk slot
+	 * @param slot Slot in map mesh
+	 * @param chunk Chunk index
+	 * @param tiles Chunk tiles, row after row
+	 * @param normals Tile normals, row after row
+	 * @param heights Chunk vertex heights, row after row
+	 */
+	void Map::FillChunk(const int slot, const int chunk, const Tile* tiles, const Vec3* normals, const jo_fixed* heights)
+	{
+		int firstX = (chunk % Map::ChunksPerSide) * Map::ChunkSize;
+		int firstY = (chunk / Map::ChunksPerSide) * Map::ChunkSize;
+		POINT* points = this->mapMesh.pntbl + (slot * Map::ChunkPointCount);
+		POLYGON* polygons = this->mapMesh.pltbl + (slot * Map::ChunkTileCount);
+		ATTR* attributes = this->mapMesh.attbl + (slot * Map::ChunkTileCount);
+
+		for (int y = 0; y <= Map::ChunkSize; y++)
+		{
+			for (int x = 0; x <= Map::ChunkSize; x++)
+			{
+				size_t index = Map::GetChunkVertexIndex(x, y, Map::ChunkSize);
+				points[index][X] = (firstX + x) << 19;
+				points[index][Y] = (firstY + y) << 19;
+				points[index][Z] = heights[index];
+			}
+		}
+
+		for (int y = 0; y < Map::ChunkSize; y++)
+		{
+			for (int x = 0; x < Map::ChunkSize; x++)
+			{
+				int local = x + (y * Map::ChunkSize);
+				size_t currentTile = Map::GetTileIndex(firstX + x, firstY + y);
+
+				// // Set polygon
+				(Vec3&)polygons[local].norm = normals[local];
+
+				// Set vertex indicies
+				size_t vertices[4] = {
+					Map::GetChunkVertexIndex(x + 1, y, Map::ChunkSize),
+					Map::GetChunkVertexIndex(x + 1, y + 1, Map::ChunkSize),
+					Map::GetChunkVertexIndex(x, y + 1, Map::ChunkSize),
+					Map::GetChunkVertexIndex(x, y, Map::ChunkSize),
+				};
+
+				// TODO: support tile rotation
+				int baseIndex = 3 - tiles[local].Rotation;
+
+				for (size_t vertex = 0; vertex < 4; vertex++)
+				{
+					if (baseIndex >= 4)
+					{
+						baseIndex = 0;
+					}
+
+					polygons[local].Vertices[baseIndex] = vertices[vertex];
+					baseIndex++;
+				}
+
+				// Set attribute
+				ATTR attribute = ATTRIBUTE(
+					Dual_Plane,
+					SORT_MAX,
+					this->tileTextures[currentTile],
+					JO_COLOR_White,
+					CL32KRGB | No_Gouraud,
+					CL32KRGB | MESHoff,
+					sprHVflip,
+					No_Option);
+
+				attribute.gstb = 0xe000 + currentTile;
+				JO_ADD_FLAG(attribute.atrb, CL_Gouraud);
+				attributes[local] = attribute;
+			}
+		}
+
+		this->nearChunks[chunk].pntbl = points;
+		this->nearChunks[chunk].nbPoint = Map::ChunkPointCount;
+		this->nearChunks[chunk].pltbl = polygons;
+		this->nearChunks[chunk].nbPolygon = Map::ChunkTileCount;
+		this->nearChunks[chunk].attbl = attributes;
+
+		this->chunkSlots[chunk] = slot;
+		this->slotChunks[slot] = chunk;
+		this->slotLastUse[slot] = this->frame;
+	}
+
+	/** @brief Build far representation of a chunk
+	 * @param chunk Chunk index
+	 * @param heights Vertex heights of the whole map
+	 * @param normals Tile normals of the whole map
+	 */
+	void Map::BuildFarChunk(const int chunk, const jo_fixed* heights, const LevelFormat::Vector* normals)
+	{
+		int firstX = (chunk % Map::ChunksPerSide) * Map::ChunkSize;
+		int firstY = (chunk / Map::ChunksPerSide) * Map::ChunkSize;
+
+		// Far points, every other vertex of the full detail chunk
+		POINT* farPoints = this->farMesh.pntbl + (chunk * Map::FarChunkPointCount);
+
+		for (int y = 0; y <= Map::FarChunkSize; y++)
+		{
+			for (int x = 0; x <= Map::FarChunkSize; x++)
+			{
+				POINT& point = farPoints[Map::GetChunkVertexIndex(x, y, Map::FarChunkSize)];
+				point[X] = (firstX + (x << 1)) << 19;
+				point[Y] = (firstY + (y << 1)) << 19;
+				point[Z] = heights[Map::GetVertexIndex(firstX + (x << 1), firstY + (y << 1))];
+			}
+		}
+
+		// Far polygons, each one covers 2x2 tiles
+		POLYGON* farPolygons = this->farMesh.pltbl + (chunk * Map::FarChunkTileCount);
+		ATTR* farAttributes = this->farMesh.attbl + (chunk * Map::FarChunkTileCount);
+
+		for (int y = 0; y < Map::FarChunkSize; y++)
+		{
+			for (int x = 0; x < Map::FarChunkSize; x++)
+			{
+				int index = x + (y * Map::FarChunkSize);
+
+				// Same winding as unrotated full detail tile
+				farPolygons[index].Vertices[0] = Map::GetChunkVertexIndex(x + 1, y + 1, Map::FarChunkSize);
+				farPolygons[index].Vertices[1] = Map::GetChunkVertexIndex(x, y + 1, Map::FarChunkSize);
+				farPolygons[index].Vertices[2] = Map::GetChunkVertexIndex(x, y, Map::FarChunkSize);
+				farPolygons[index].Vertices[3] = Map::GetChunkVertexIndex(x + 1, y, Map::FarChunkSize);
+
+				// Average normal of merged tiles
+				Vec3 normal;
+
+				for (int tile = 0; tile < 4; tile++)
+				{
+					int tileX = firstX + (x << 1) + (tile & 1);
+					int tileY = firstY + (y << 1) + (tile >> 1);
+					normal += (const Vec3&)normals[Map::GetTileIndex(tileX, tileY)];
+				}
+
+				Fxp length = normal.Length();
+				(Vec3&)farPolygons[index].norm = length != 0.0 ? normal / length : normal;
+
+				farAttributes[index] = ATTRIBUTE(
+					Dual_Plane,
+					SORT_MAX,
+					No_Texture,
+					JO_COLOR_White,
+					CL32KRGB | No_Gouraud,
+					CL32KRGB | MESHoff,
+					sprPolygon,
+					No_Option);
+			}
+		}
+
+		this->farChunks[chunk].pntbl = farPoints;
+		this->farChunks[chunk].nbPoint = Map::FarChunkPointCount;
+		this->farChunks[chunk].pltbl = farPolygons;
+		this->farChunks[chunk].nbPolygon = Map::FarChunkTileCount;
+		this->farChunks[chunk].attbl = farAttributes;
+
+		this->UpdateFarColors(chunk);
+	}
+
+	/** @brief Recalculate flat colors of a far chunk from texture colors and gouraud table
+	 * @param chunk Chunk index
+	 */
+	void Map::UpdateFarColors(const int chunk)
+	{
+		int firstX = (chunk % Map::ChunksPerSide) * Map::ChunkSize;
+		int firstY = (chunk / Map::ChunksPerSide) * Map::ChunkSize;
+		ATTR* farAttributes = this->farMesh.attbl + (chunk * Map::FarChunkTileCount);
+
+		for (int index = 0; index < Map::FarChunkTileCount; index++)
+		{
+			int red = 0;
+			int green = 0;
+			int blue = 0;
+
+			for (int tile = 0; tile < 4; tile++)
+			{
+				int tileX = firstX + ((index % Map::FarChunkSize) << 1) + (tile & 1);
+				int tileY = firstY + ((index / Map::FarChunkSize) << 1) + (tile >> 1);
+				jo_color texture = PakTextureLoader::GetAverageColor(this->tileTextures[Map::GetTileIndex(tileX, tileY)]);
+
+				// Gouraud is added to texture color, 16 is neutral
+				for (jo_color gouraud : this->gouraudTable[Map::GetTileIndex(tileX, tileY)])
+				{
+					red += JO_COLOR_SATURN_GET_R(texture) + JO_COLOR_SATURN_GET_R(gouraud) - 16;
+					green += JO_COLOR_SATURN_GET_G(texture) + JO_COLOR_SATURN_GET_G(gouraud) - 16;
+					blue += JO_COLOR_SATURN_GET_B(texture) + JO_COLOR_SATURN_GET_B(gouraud) - 16;
+				}
+			}
+
+			// 4 tiles with 4 vertices each
+			farAttributes[index].colno = JO_COLOR_SATURN_RGB(
+				JO_MIN(JO_MAX(red >> 4, 0), 31),
+				JO_MIN(JO_MAX(green >> 4, 0), 31),
+				JO_MIN(JO_MAX(blue >> 4, 0), 31));
+		}
+	}
+
+	/** @brief Decide whether chunk should be drawn with far representation
+	 * @param chunk Chunk index
+	 * @return True if chunk is far from camera
+	 */
+	bool Map::IsChunkFar(const int chunk)
+	{
+		// Center point of the far chunk is also center of the chunk
+		POINT& center = this->farMesh.pntbl[(chunk * Map::FarChunkPointCount) + Map::GetChunkVertexIndex(Map::FarChunkSize >> 1, Map::FarChunkSize >> 1, Map::FarChunkSize)];
+		FIXED view[XYZ];
+		slCalcPoint(center[X], center[Y], center[Z], view);
+
+		// Hysteresis, so chunks on the edge do not flicker between representations
+		uint32_t bit = (uint32_t)1 << chunk;
+		jo_fixed threshold = (this->farChunkMask & bit) != 0 ? Map::NearChunkDistance : Map::FarChunkDistance;
+
+		// Shedding distant gouraud pulls flat far representation closer to the camera
+		if (!FrameGovernor::IsEnabled(FrameGovernor::Feature::DistantGouraud))
+		{
+			threshold >>= 1;
+		}
+
+		if (view[Z] > threshold)
+		{
+			this->farChunkMask |= bit;
+			return true;
+		}
+
+		this->farChunkMask &= ~bit;
+		return false;
+	}
+
+	/** @brief Set region full detail terrain is needed in, chunks around it are prefetched
+	 * @param fromX First tile X location
+	 * @param fromY First tile Y location
+	 * @param toX Last tile X location
+	 * @param toY Last tile Y location
+	 */
+	void Map::SetFocus(int fromX, int fromY, int toX, int toY)
+	{
+		int fromChunkX = JO_MAX(JO_MIN(fromX, toX) / Map::ChunkSize - Map::PrefetchRing, 0);
+		int fromChunkY = JO_MAX(JO_MIN(fromY, toY) / Map::ChunkSize - Map::PrefetchRing, 0);
+		int toChunkX = JO_MIN(JO_MAX(fromX, toX) / Map::ChunkSize + Map::PrefetchRing, Map::ChunksPerSide - 1);
+		int toChunkY = JO_MIN(JO_MAX(fromY, toY) / Map::ChunkSize + Map::PrefetchRing, Map::ChunksPerSide - 1);
+
+		this->focusX = (fromChunkX + toChunkX) >> 1;
+		this->focusY = (fromChunkY + toChunkY) >> 1;
+		this->wantedChunks = 0;
+
+		for (int chunkY = fromChunkY; chunkY <= toChunkY; chunkY++)
+		{
+			for (int chunkX = fromChunkX; chunkX <= toChunkX; chunkX++)
+			{
+				this->wantedChunks |= (uint32_t)1 << (chunkX + (chunkY * Map::ChunksPerSide));
+			}
+		}
+	}
+
+	/** @brief Check whether all chunks of focused region are resident
+	 * @return True if resident
+	 */
+	bool Map::IsFocusResident()
+	{
+		for (int chunk = 0; chunk < Map::ChunkCount; chunk++)
+		{
+			if ((this->wantedChunks & ((uint32_t)1 << chunk)) != 0 && this->chunkSlots[chunk] < 0)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/** @brief Start reading next missing chunk, called by Draw() each frame
+	 */
+	void Map::UpdateStreaming()
+	{
+		this->frame++;
+
+		// Only one chunk is read at a time, so CD seeks stay short
+		if (this->loadingChunk < 0)
+		{
+			this->RequestChunk();
+		}
+	}
+
+	/** @brief Pick next chunk to read from the CD and a slot for it
+	 */
+	void Map::RequestChunk()
+	{
+		// Nearest missing chunk first
+		int chunk = -1;
+		int nearest = Map::ChunksPerSide * 2;
+
+		for (int candidate = 0; candidate < Map::ChunkCount; candidate++)
+		{
+			if ((this->wantedChunks & ((uint32_t)1 << candidate)) == 0 || this->chunkSlots[candidate] >= 0)
+			{
+				continue;
+			}
+
+			int distance = JO_ABS((candidate % Map::ChunksPerSide) - this->focusX) + JO_ABS((candidate / Map::ChunksPerSide) - this->focusY);
+
+			if (distance < nearest)
+			{
+				nearest = distance;
+				chunk = candidate;
+			}
+		}
+
+		if (chunk < 0)
+		{
+			return;
+		}
+
+		// Free slot or least recently used slot that is not wanted anymore
+		int slot = -1;
+
+		for (int candidate = 0; candidate < this->slotCount; candidate++)
+		{
+			int resident = this->slotChunks[candidate];
+
+			if (resident < 0)
+			{
+				slot = candidate;
+				break;
+			}
+
+			if ((this->wantedChunks & ((uint32_t)1 << resident)) == 0 &&
+				(slot < 0 || this->slotLastUse[candidate] < this->slotLastUse[slot]))
+			{
+				slot = candidate;
+			}
+		}
+
+		if (slot < 0)
+		{
+			// Focused region is bigger than what we can keep in memory
+			return;
+		}
+
+		// Read is retried next frame if file system is busy
+		if (jo_fs_read_sectors_async_with_priority(this->chunkFile, chunk, 1, JO_FS_PRIORITY_STREAM, Map::ChunkRead, chunk, Map::chunkBuffer))
+		{
+			if (this->slotChunks[slot] >= 0)
+			{
+				this->chunkSlots[this->slotChunks[slot]] = -1;
+				this->slotChunks[slot] = -1;
+			}
+
+			this->loadingChunk = chunk;
+		}
+	}
+
+	/** @brief Chunk sector was read
+	 * @param contents Chunk data
+	 * @param length Data length
+	 * @param token Chunk index
+	 */
+	void Map::ChunkRead(char* contents, int length, int token)
+	{
+		Map* map = Map::streamingMap;
+
+		if (map == nullptr || map->loadingChunk != token)
+		{
+			return;
+		}
+
+		map->loadingChunk = -1;
+
+		if (length < (int)sizeof(ChunkData))
+		{
+			return;
+		}
+
+		// Claim slot freed when the read started
+		int slot = 0;
+
+		while (slot < map->slotCount && map->slotChunks[slot] >= 0)
+		{
+			slot++;
+		}
+
+		if (slot >= map->slotCount)
+		{
+			return;
+		}
+
+		const ChunkData* data = (const ChunkData*)contents;
+		map->FillChunk(slot, token, data->TileData, (const Vec3*)data->Normals, data->Heights);
+	}
+
+	/** @brief Change level sun, all tiles will be relit over the next few frames
+	 * @param direction Light direction
+	 * @param color Light color
+	 */
+	void Map::SetSun(const Vec3& direction, jo_color color)
+	{
+		this->Light.Direction = direction;
+		this->Light.Color = color;
+
+		Vec3 vector = -this->Light.Direction;
+		slLight((FIXED*)&vector);
+
+		this->InvalidateLighting(Map::MapDimensionSize >> 1, Map::MapDimensionSize >> 1, Map::MapDimensionSize);
+	}
+
+	/** @brief Mark tiles around location for relighting
+	 * @param x Tile X location
+	 * @param y Tile Y location
+	 * @param radius Radius in number of tiles (1, would be an area 3x3)
+	 */
+	void Map::InvalidateLighting(int x, int y, int radius)
+	{
+		int fromX = JO_MAX(x - radius, 0);
+		int toX = JO_MIN(x + radius, Map::MapDimensionSize - 1);
+		int fromY = JO_MAX(y - radius, 0);
+		int toY = JO_MIN(y + radius, Map::MapDimensionSize - 1);
+
+		for (int tileY = fromY; tileY <= toY; tileY++)
+		{
+			for (int tileX = fromX; tileX <= toX; tileX++)
+			{
+				size_t tile = Map::GetTileIndex(tileX, tileY);
+				uint32_t bit = (uint32_t)1 << (tile & 31);
+
+				if ((this->dirtyTiles[tile >> 5] & bit) == 0)
+				{
+					this->dirtyTiles[tile >> 5] |= bit;
+					this->dirtyTileCount++;
+				}
+			}
+		}
+	}
+
+	/** @brief Relight dirty tiles and upload changed part of the gouraud table
+	 */
+	void Map::UpdateLighting()
+	{
+		// Previous upload must finish before we touch the table again
+		slDMAWait();
+
+		int budget = Map::RelightTilesPerFrame;
+		int first = -1;
+		int last = -1;
+
+		for (size_t word = 0; word < sizeof(this->dirtyTiles) / sizeof(uint32_t) && budget > 0; word++)
+		{
+			while (this->dirtyTiles[word] != 0 && budget > 0)
+			{
+				// Take lowest dirty bit
+				uint32_t mask = this->dirtyTiles[word];
+				int bit = 0;
+
+				while ((mask & ((uint32_t)1 << bit)) == 0)
+				{
+					bit++;
+				}
+
+				this->dirtyTiles[word] &= ~((uint32_t)1 << bit);
+				this->dirtyTileCount--;
+				budget--;
+
+				int tile = (word << 5) + bit;
+				this->RelightTile(tile);
+
+				int tileX = tile % Map::MapDimensionSize;
+				int tileY = tile / Map::MapDimensionSize;
+				this->staleFarChunks |= (uint32_t)1 << ((tileX / Map::ChunkSize) + ((tileY / Map::ChunkSize) * Map::ChunksPerSide));
+
+				if (first < 0)
+				{
+					first = tile;
+				}
+
+				last = tile;
+			}
+		}
+
+		if (first >= 0)
+		{
+			this->UploadGouraud(first, last);
+		}
 	}
 
 
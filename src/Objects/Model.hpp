@@ -4,6 +4,7 @@
 #include "..\utils\LoaderUtil.hpp"
 
 #include "Mesh3D.hpp"
+#include "..\Utils\RenderStats.hpp"
 
 /** @brief Game objects
  */
@@ -92,10 +93,61 @@ namespace Objects
 			int32_t Texture;
 		};
 
+		/** @brief Optional block after textures describing level of detail chains
+		 */
+		struct LodHeader
+		{
+			/** @brief Block identifier (should read 'LOD' and 4th byte indicates version)
+			 */
+			char Identifier[4];
+
+			/** @brief Number of following LOD entries
+			 */
+			uint32_t Count;
+		};
+
+		/** @brief Link between a mesh and its lower detail level
+		 */
+		struct LodEntry
+		{
+			/** @brief Index of the mesh
+			 */
+			uint16_t Mesh;
+
+			/** @brief Index of the lower detail mesh, it can have its own lower level forming a chain, must be higher than Mesh
+			 */
+			uint16_t Level;
+
+			/** @brief View depth from which lower detail mesh is used (16.16)
+			 */
+			int32_t Distance;
+		};
+
+		/** @brief Level of detail of a loaded mesh
+		 */
+		struct LodLevel
+		{
+			/** @brief Index of the lower detail mesh or -1 if there is none
+			 */
+			int16_t Next;
+
+			/** @brief Indicates whether mesh is only drawn as lower detail level of other mesh
+			 */
+			bool IsLowerLevel;
+
+			/** @brief View depth from which lower detail mesh is used
+			 */
+			Fxp Distance;
+		};
+
 		/** @brief Loaded mesh data
 		 */
 		Mesh3D* meshes;
 
+		/** @brief Level of detail of each mesh, nullptr if model has no detail levels
+		 */
+		LodLevel* lods;
+
 		/** @brief Number of loaded meshes
 		 */
 		size_t meshCount;
@@ -108,13 +160,43 @@ namespace Objects
 		 */
 		size_t textureCount;
 
+		/** @brief Radius of a sphere around model origin enclosing all meshes
+		 */
+		Fxp radius;
+
+		/** @brief Get depth of model origin in view space
+		 * @return View depth under current matrix
+		 */
+		static Fxp GetViewDepth()
+		{
+			FIXED view[XYZ];
+			slCalcPoint(0, 0, 0, view);
+			return Fxp::BuildRaw(view[Z]);
+		}
+
+		/** @brief Walk level of detail chain of a mesh
+		 * @param mesh Mesh index
+		 * @param depth View depth of model origin
+		 * @return Index of mesh to draw
+		 */
+		size_t SelectLevel(size_t mesh, const Fxp& depth) const
+		{
+			while (this->lods[mesh].Next >= 0 && depth >= this->lods[mesh].Distance)
+			{
+				mesh = this->lods[mesh].Next;
+			}
+
+			return mesh;
+		}
+
 	public:
 		/** @brief Initializes a new model object from a file
 		 * @param modelFile Model file
 		 */
 		Model(const char* modelFile)
 		{
-			char* fileBuffer = jo_fs_read_file_in_dir(modelFile, JO_ROOT_DIR, NULL);
+			int fileLength = 0;
+			char* fileBuffer = jo_fs_read_file_in_dir(modelFile, JO_ROOT_DIR, &fileLength);
 			char* iterator = fileBuffer;
 
 			uint16_t lastTextureIndex = jo_sprite_count();
@@ -124,8 +206,10 @@ namespace Objects
 			this->startTextureIndex = -1;
 			this->textureCount = header->TextureCount;
 			this->meshCount = header->MeshCount;
+			this->lods = nullptr;
 
 			this->meshes = new Mesh3D[this->meshCount];
+			this->radius = 0.0;
 
 			for (size_t meshIndex = 0; meshIndex < this->meshCount; meshIndex++)
 			{
@@ -144,6 +228,14 @@ namespace Objects
 				for (size_t pointIndex = 0; pointIndex < meshHeader->PointCount; pointIndex++)
 				{
 					mesh.PointTable()[pointIndex] <<= 3;
+
+					// Large models would overflow squared length
+					Fxp distance = mesh.PointTable()[pointIndex].TurboLength();
+
+					if (distance > this->radius)
+					{
+						this->radius = distance;
+					}
 				}
 
 				for (size_t attributeIndex = 0; attributeIndex < meshHeader->PolygonCount; attributeIndex++)
@@ -186,6 +278,9 @@ namespace Objects
 				this->meshes[meshIndex] = std::move(mesh);
 			}
 
+			// Approximated length can be few percent short
+			this->radius += this->radius >> 3;
+
 			// Load textures
 			for (size_t textureIndex = 0; textureIndex < textureCount; textureIndex++)
 			{
@@ -202,6 +297,37 @@ namespace Objects
 				}
 			}
 
+			// Load detail levels, older files end after textures
+			if (fileLength - (iterator - fileBuffer) >= (int)sizeof(LodHeader))
+			{
+				LodHeader* lodHeader = GetAndIterate<LodHeader>(iterator);
+
+				if (lodHeader->Identifier[0] == 'L' && lodHeader->Identifier[1] == 'O' && lodHeader->Identifier[2] == 'D')
+				{
+					this->lods = new LodLevel[this->meshCount];
+
+					for (size_t meshIndex = 0; meshIndex < this->meshCount; meshIndex++)
+					{
+						this->lods[meshIndex] = { -1, false, 0.0 };
+					}
+
+					// Damaged header must not read past the end of the file
+					size_t count = JO_MIN((size_t)lodHeader->Count, (size_t)(fileLength - (iterator - fileBuffer)) / sizeof(LodEntry));
+					LodEntry* entries = GetAndIterate<LodEntry>(iterator, count);
+
+					for (size_t entry = 0; entry < count; entry++)
+					{
+						// Lower level always comes after its mesh, so the chain can not loop
+						if (entries[entry].Mesh < entries[entry].Level && entries[entry].Level < this->meshCount)
+						{
+							this->lods[entries[entry].Mesh].Next = entries[entry].Level;
+							this->lods[entries[entry].Mesh].Distance = Fxp::BuildRaw(entries[entry].Distance);
+							this->lods[entries[entry].Level].IsLowerLevel = true;
+						}
+					}
+				}
+			}
+
 			// Free the read file
 			jo_free(fileBuffer);
 		}
@@ -211,30 +337,68 @@ namespace Objects
 		~Model()
 		{
 			delete[] meshes;
+			delete[] lods;
 			meshCount = 0;
 		}
 
-		/** @brief Draw specified mesh
+		/** @brief Draw lower detail levels of models far from the camera
+		 */
+		inline static bool LodEnabled = true;
+
+		/** @brief Draw specified mesh, lower detail level is picked from view depth
 		 * @param mesh Mesh index
 		 */
 		void Draw(size_t mesh)
 		{
 			if (mesh < meshCount)
 			{
+				if (this->lods != nullptr && Model::LodEnabled)
+				{
+					mesh = this->SelectLevel(mesh, Model::GetViewDepth());
+				}
+
+				RenderStats::AddPolygons(meshes[mesh].nbPolygon);
 				jo_3d_mesh_draw(meshes[mesh].JoPtr());
 			}
 		}
 
-		/** @brief Draw all loaded meshes
+		/** @brief Draw all loaded meshes, lower detail levels are picked from view depth
 		 */
 		void Draw()
 		{
+			if (this->lods == nullptr)
+			{
+				for (size_t mesh = 0; mesh < meshCount; mesh++)
+				{
+					RenderStats::AddPolygons(meshes[mesh].nbPolygon);
+					jo_3d_mesh_draw(meshes[mesh].JoPtr());
+				}
+
+				return;
+			}
+
+			Fxp depth = Model::GetViewDepth();
+
 			for (size_t mesh = 0; mesh < meshCount; mesh++)
 			{
-				jo_3d_mesh_draw(meshes[mesh].JoPtr());
+				if (!this->lods[mesh].IsLowerLevel)
+				{
+					size_t level = Model::LodEnabled ? this->SelectLevel(mesh, depth) : mesh;
+					RenderStats::AddPolygons(meshes[level].nbPolygon);
+					jo_3d_mesh_draw(meshes[level].JoPtr());
+				}
 			}
 		}
 
+		/** @brief Check whether mesh is only a lower detail level of other mesh
+		 * @param mesh Mesh index
+		 * @return True if mesh is not drawn on its own
+		 */
+		bool IsLowerLevel(size_t mesh) const
+		{
+			return this->lods != nullptr && mesh < this->meshCount && this->lods[mesh].IsLowerLevel;
+		}
+
 		/** @brief Get index of the first texture loaded
 		 * @return Index of first texture or -1 if model has no textures
 		 */
@@ -243,6 +407,23 @@ namespace Objects
 			return this->startTextureIndex;
 		}
 
+		/** @brief Get radius of a sphere around model origin enclosing all meshes
+		 * @return Bounding radius
+		 */
+		constexpr Fxp GetRadius()
+		{
+			return this->radius;
+		}
+
+		/** @brief Get loaded mesh
+		 * @param mesh Mesh index
+		 * @return Mesh or nullptr if index is out of range
+		 */
+		const Mesh3D* GetMesh(size_t mesh) const
+		{
+			return mesh < this->meshCount ? &this->meshes[mesh] : nullptr;
+		}
+
 		/** @brief Gets number of loaded meshes
 		 * @return Number of loaded meshes
 		 */
@@ -0,0 +1,195 @@
+#pragma once
+
+#ifdef BENCHMARK_MODE
+
+#include <jo/Jo.hpp>
+
+#include "Debug.hpp"
+#include "FrameGovernor.hpp"
+#include "Profiler.hpp"
+#include "RenderStats.hpp"
+#include "Replay.hpp"
+#include "Settings.hpp"
+#include "SimulationClock.hpp"
+
+#ifndef BENCHMARK_STAGE
+#define BENCHMARK_STAGE 0
+#endif
+
+#ifndef BENCHMARK_PLAYERS
+#define BENCHMARK_PLAYERS 4
+#endif
+
+#ifndef BENCHMARK_SEED
+#define BENCHMARK_SEED 12345
+#endif
+
+#ifndef BENCHMARK_FRAMES
+#define BENCHMARK_FRAMES 3000
+#endif
+
+static_assert(Debug::Enabled, "Benchmark reads profiler and render counters, build it with ENABLE_DEBUG");
+
+/** @brief Unattended benchmark, boots straight into a scripted match and reports frame timings after a fixed number of frames
+ * @details Simulation runs one tick per frame and frame governor is off, so every run does the same work frame by frame
+ * no matter how fast it is. Results are printed on screen and kept in Benchmark::Results, which starts with "BNCH"
+ * so it can be found in a memory dump or through the linker map.
+ */
+struct Benchmark
+{
+	/** @brief Results of the run
+	 */
+	struct Report
+	{
+		/** @brief Always "BNCH"
+		 */
+		char Magic[4];
+
+		/** @brief Indicates whether run finished, 0 while running
+		 */
+		uint32_t Done;
+
+		/** @brief Number of measured frames
+		 */
+		uint32_t Frames;
+
+		/** @brief Highest work RAM heap usage in percent
+		 */
+		uint32_t PeakMemoryPercent;
+
+		/** @brief Highest sprite VRAM usage in percent
+		 */
+		uint32_t PeakVramPercent;
+
+		/** @brief Most polygons in a single frame
+		 */
+		uint32_t PeakPolygons;
+
+		/** @brief Most sprites in a single frame
+		 */
+		uint32_t PeakSprites;
+
+		/** @brief Number of profiled sections
+		 */
+		uint32_t SectionCount;
+
+		/** @brief Section names
+		 */
+		char Names[Profiler::MaxSections][12];
+
+		/** @brief Average time per frame of each section in microseconds
+		 */
+		uint32_t Average[Profiler::MaxSections];
+
+		/** @brief Slowest frame of each section in microseconds
+		 */
+		uint32_t Peak[Profiler::MaxSections];
+
+		/** @brief Frames of each section sorted into one millisecond buckets
+		 */
+		uint32_t Histogram[Profiler::MaxSections][Profiler::HistogramBuckets];
+	};
+
+	/** @brief Results of the run
+	 */
+	inline static Report Results = { { 'B', 'N', 'C', 'H' } };
+
+private:
+	/** @brief Number of frames to measure
+	 */
+	static const uint32_t FrameCount = BENCHMARK_FRAMES;
+
+	/** @brief Number of measured frames
+	 */
+	inline static uint32_t frame = 0;
+
+	/** @brief Collect results, print them and stop
+	 */
+	static void Finish()
+	{
+		Report& report = Benchmark::Results;
+		report.Frames = Benchmark::frame;
+		report.PeakPolygons = RenderStats::GetPeakPolygons();
+		report.PeakSprites = RenderStats::GetPeakSprites();
+		report.SectionCount = Profiler::GetSectionCount();
+
+		jo_clear_screen();
+		jo_printf(0, 0, "BENCH %s %dP %d FRAMES", Settings::StageNames[Settings::SelectedStage], Settings::PlayerCount, report.Frames);
+		jo_printf(0, 1, "SECTION      AVG   P95   MAX");
+
+		for (uint32_t section = 0; section < report.SectionCount; section++)
+		{
+			Profiler::Summary summary = Profiler::GetSummary(section);
+			uint32_t seen = 0;
+			int percentile = Profiler::HistogramBuckets - 1;
+
+			for (int bucket = 0; bucket < Profiler::HistogramBuckets; bucket++)
+			{
+				report.Histogram[section][bucket] = summary.Histogram[bucket];
+				seen += summary.Histogram[bucket];
+
+				if (percentile == Profiler::HistogramBuckets - 1 && seen * 100 >= summary.Frames * 95)
+				{
+					percentile = bucket;
+				}
+			}
+
+			strncpy(report.Names[section], summary.Name, sizeof(report.Names[section]) - 1);
+			report.Average[section] = summary.Average;
+			report.Peak[section] = summary.Peak;
+
+			// Percentile is known only to the bucket, upper edge is printed
+			jo_printf(0, 2 + section, "%-10s %5d %4dm %5d", summary.Name, summary.Average, percentile + 1, summary.Peak);
+		}
+
+		jo_printf(0, 3 + report.SectionCount, "MEM %d%% VRAM %d%%", report.PeakMemoryPercent, report.PeakVramPercent);
+		jo_printf(0, 4 + report.SectionCount, "POLY %d SPR %d", report.PeakPolygons, report.PeakSprites);
+		report.Done = 1;
+
+		while (true)
+		{
+			slSynch();
+		}
+	}
+
+public:
+	/** @brief Random seed of the benchmark match
+	 */
+	static const int Seed = BENCHMARK_SEED;
+
+	/** @brief Set up benchmark match, should be called once before main loop
+	 */
+	static void Start()
+	{
+		Settings::SelectedStage = JO_MIN(BENCHMARK_STAGE, Settings::StageCount - 1);
+		Settings::PlayerCount = JO_MAX(JO_MIN(BENCHMARK_PLAYERS, Settings::MaxPlayerCount), (size_t)2);
+
+		// Timer must not run out before the last frame
+		Settings::TotalSeconds = (Benchmark::FrameCount / SimulationClock::TicksPerSecond) + 10;
+		Settings::IsActive = true;
+
+		Replay::SetScript(Replay::Wander);
+		SimulationClock::LockStepEnabled = true;
+		FrameGovernor::Enabled = false;
+	}
+
+	/** @brief Count finished frame, reports and stops once enough frames were measured or the match ended
+	 * @param inMatch Indicates whether this frame simulated and drew a loaded match
+	 */
+	static void EndFrame(bool inMatch)
+	{
+		if (inMatch)
+		{
+			Benchmark::frame++;
+			Benchmark::Results.PeakMemoryPercent = JO_MAX(Benchmark::Results.PeakMemoryPercent, (uint32_t)jo_memory_usage_percent());
+			Benchmark::Results.PeakVramPercent = JO_MAX(Benchmark::Results.PeakVramPercent, (uint32_t)jo_sprite_usage_percent());
+		}
+
+		if (Benchmark::frame >= Benchmark::FrameCount || Settings::GameEnded)
+		{
+			Benchmark::Finish();
+		}
+	}
+};
+
+#endif
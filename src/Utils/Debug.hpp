@@ -4,13 +4,17 @@
 
 class Debug
 {
+public:
+    // Log wraps above this line, lines below are left to the render stats overlay
+    static constexpr uint8_t LogLines = 25;
+
 private:
     static inline uint8_t line = 0;
     static inline uint8_t logCounter = 0;
 
     static auto GetNextLineToPrint()
     {
-        if (line > 26)
+        if (line >= LogLines)
         {
             line = 0;
         }
@@ -39,6 +43,15 @@ public:
         }
     }
 
+    template <typename ...Args>
+    static void Print(int x, int y, Args...args)
+    {
+        if constexpr (Enabled)
+        {
+            jo_printf(x, y, args ...);
+        }
+    }
+
     template <typename ...Args>
     static void LogLineAndBreak(Args...args)
     {
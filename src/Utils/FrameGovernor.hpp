@@ -0,0 +1,180 @@
+#pragma once
+
+#include <jo/Jo.hpp>
+
+#include "SimulationClock.hpp"
+
+/** @brief Sheds optional work level by level while frames take longer than the frame budget
+ * @details Frame cost is measured with the free running timer, which is reset at the start of the frame by
+ * jo_fixed_point_time(). Work time is taken once all CPU work is done and the whole frame period after synch,
+ * so frames that miss the vertical blank because of VDP1 count as well. Late frames count with their period,
+ * frames on time with their work time, which is what tells how much headroom is left. Levels go up fast when
+ * over budget and come back down slowly when there is headroom, so detail does not flicker on and off.
+ */
+struct FrameGovernor
+{
+	/** @brief Optional work that can be shed
+	 */
+	enum class Feature : uint8_t
+	{
+		/** @brief Explosion sprites
+		 */
+		Explosions,
+
+		/** @brief Static props on chunks drawn with far representation
+		 */
+		FarProps,
+
+		/** @brief Gouraud shaded full detail tiles in the distance, chunks switch to far representation sooner
+		 */
+		DistantGouraud,
+
+		/** @brief HUD rebuilt every frame it changes
+		 */
+		HudRefresh,
+
+		/** @brief Number of features
+		 */
+		Count
+	};
+
+	/** @brief Level from which each feature is shed
+	 */
+	inline static uint8_t ShedLevels[(int)Feature::Count] = { 1, 2, 3, 4 };
+
+	/** @brief Highest level governor can reach
+	 */
+	inline static int MaxLevel = 4;
+
+	/** @brief Frame cost in percent of budget above which detail is shed
+	 */
+	inline static int ShedPercent = 95;
+
+	/** @brief Frame cost in percent of budget below which detail is restored
+	 */
+	inline static int RestorePercent = 70;
+
+	/** @brief Number of frames over budget before going one level up
+	 */
+	inline static int ShedFrames = 2;
+
+	/** @brief Number of frames with headroom before going one level down
+	 */
+	inline static int RestoreFrames = 60;
+
+	/** @brief Indicates whether governor changes levels at all
+	 */
+	inline static bool Enabled = true;
+
+private:
+	/** @brief Time of a single displayed frame in microseconds
+	 */
+	static const int FrameBudget = 1000000 / SimulationClock::TicksPerSecond;
+
+	/** @brief Frame period above which frame missed its vertical blank
+	 */
+	static const int LatePeriod = FrameGovernor::FrameBudget + (FrameGovernor::FrameBudget / 2);
+
+	/** @brief Current level, 0 means everything is drawn
+	 */
+	inline static int level = 0;
+
+	/** @brief Smoothed frame cost in percent of budget
+	 */
+	inline static int cost = 0;
+
+	/** @brief CPU work time of current frame in microseconds
+	 */
+	inline static int work = 0;
+
+	/** @brief Number of consecutive frames on the same side of the thresholds
+	 */
+	inline static int streak = 0;
+
+public:
+	/** @brief Check whether feature should run this frame
+	 * @param feature Optional feature
+	 * @return True if not shed
+	 */
+	static bool IsEnabled(Feature feature)
+	{
+		return FrameGovernor::level < FrameGovernor::ShedLevels[(int)feature];
+	}
+
+	/** @brief Get current level
+	 * @return Level, 0 means everything is drawn
+	 */
+	static int GetLevel()
+	{
+		return FrameGovernor::level;
+	}
+
+	/** @brief Get smoothed frame cost
+	 * @return Cost in percent of budget
+	 */
+	static int GetCost()
+	{
+		return FrameGovernor::cost;
+	}
+
+	/** @brief Draw everything again and forget measured cost, used when a match starts
+	 */
+	static void Reset()
+	{
+		FrameGovernor::level = 0;
+		FrameGovernor::cost = 0;
+		FrameGovernor::work = 0;
+		FrameGovernor::streak = 0;
+	}
+
+	/** @brief Measure CPU work time of the frame, should be called once all work of the frame is done, before synch
+	 */
+	static void EndWork()
+	{
+		FrameGovernor::work = (int)jo_time_frc_to_microseconds(jo_time_get_frc());
+	}
+
+	/** @brief Measure cost of the frame and change level, should be called right after synch
+	 */
+	static void EndFrame()
+	{
+		// Counter is reset at the start of the frame, after synch it holds the whole frame period
+		int period = (int)jo_time_frc_to_microseconds(jo_time_get_frc());
+		int frameTime = period > FrameGovernor::LatePeriod ? period : FrameGovernor::work;
+		int percent = (frameTime * 100) / FrameGovernor::FrameBudget;
+
+		// Smoothed, so a single spike does not shed anything
+		FrameGovernor::cost = ((FrameGovernor::cost * 3) + percent) >> 2;
+
+		if (!FrameGovernor::Enabled)
+		{
+			FrameGovernor::level = 0;
+			return;
+		}
+
+		if (FrameGovernor::cost > FrameGovernor::ShedPercent && FrameGovernor::level < FrameGovernor::MaxLevel)
+		{
+			FrameGovernor::streak = JO_MAX(FrameGovernor::streak, 0) + 1;
+
+			if (FrameGovernor::streak >= FrameGovernor::ShedFrames)
+			{
+				FrameGovernor::level++;
+				FrameGovernor::streak = 0;
+			}
+		}
+		else if (FrameGovernor::cost < FrameGovernor::RestorePercent && FrameGovernor::level > 0)
+		{
+			FrameGovernor::streak = JO_MIN(FrameGovernor::streak, 0) - 1;
+
+			if (-FrameGovernor::streak >= FrameGovernor::RestoreFrames)
+			{
+				FrameGovernor::level--;
+				FrameGovernor::streak = 0;
+			}
+		}
+		else
+		{
+			FrameGovernor::streak = 0;
+		}
+	}
+};
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <jo/Jo.hpp>
+
+/** @brief Controller state of the frame
+ * @details Connected controllers are given to players in port order and their keys are packed into a snapshot once
+ * per frame, right after jo engine read them during vertical blank. Every input query of the frame reads the snapshot
+ * instead of scanning ports again. Snapshot keeps held keys in low half and keys down in high half.
+ * Simulation ticks get only the gameplay keys, packed same as replays with held keys in low byte and keys down in high byte.
+ * Simulation ticks do not line up with frames, so keys down are also latched until a tick takes them. A press in a frame
+ * that runs no tick reaches the next one, and a frame that runs several ticks gives it to the first one only.
+ */
+struct Input
+{
+	/** @brief Number of keys kept in the snapshot
+	 */
+	static constexpr int KeyCount = 13;
+
+	/** @brief Keys kept in the snapshot, one bit each, gameplay keys first
+	 */
+	static constexpr jo_gamepad_keys Keys[Input::KeyCount] = {
+		JO_KEY_UP, JO_KEY_DOWN, JO_KEY_LEFT, JO_KEY_RIGHT, JO_KEY_A, JO_KEY_B, JO_KEY_C, JO_KEY_START,
+		JO_KEY_X, JO_KEY_Y, JO_KEY_Z, JO_KEY_L, JO_KEY_R
+	};
+
+	/** @brief Number of gameplay keys, only these are given to simulation ticks and recorded
+	 */
+	static constexpr int TickKeys = 8;
+
+private:
+	/** @brief Controller port of each player
+	 */
+	inline static int ports[JO_INPUT_MAX_DEVICE];
+
+	/** @brief Snapshot of each player
+	 */
+	inline static uint32_t snapshot[JO_INPUT_MAX_DEVICE];
+
+	/** @brief Gameplay keys down of each player not yet taken by a simulation tick, in high byte
+	 */
+	inline static uint16_t latched[JO_INPUT_MAX_DEVICE];
+
+	/** @brief Number of connected controllers
+	 */
+	inline static int connected = 0;
+
+public:
+	/** @brief Get bit of a key in the snapshot
+	 * @param key Controller button
+	 * @return Bit mask, 0 if key is not kept
+	 */
+	static uint16_t GetKeyBit(jo_gamepad_keys key)
+	{
+		for (int bit = 0; bit < Input::KeyCount; bit++)
+		{
+			if (Input::Keys[bit] == key)
+			{
+				return 1 << bit;
+			}
+		}
+
+		return 0;
+	}
+
+	/** @brief Take snapshot of all controllers, should be called once at the start of each frame
+	 */
+	static void Update()
+	{
+		int previous = Input::connected;
+		Input::connected = 0;
+
+		for (int port = 0; port < JO_INPUT_MAX_DEVICE; port++)
+		{
+			if (!jo_is_input_available(port))
+			{
+				continue;
+			}
+
+			uint32_t keys = 0;
+
+			for (int bit = 0; bit < Input::KeyCount; bit++)
+			{
+				if (jo_is_input_key_pressed(port, Input::Keys[bit]))
+				{
+					keys |= 1 << bit;
+				}
+
+				if (jo_is_input_key_down(port, Input::Keys[bit]))
+				{
+					keys |= 0x10000 << bit;
+				}
+			}
+
+			// Presses of a controller that was given to someone else are dropped
+			if (Input::connected >= previous || Input::ports[Input::connected] != port)
+			{
+				Input::latched[Input::connected] = 0;
+			}
+
+			Input::ports[Input::connected] = port;
+			Input::snapshot[Input::connected] = keys;
+			Input::latched[Input::connected] |= (keys >> 8) & 0xff00;
+			Input::connected++;
+		}
+	}
+
+	/** @brief Drop keys down latched for simulation, should be called after each tick and once per frame outside of a match
+	 */
+	static void ConsumeDown()
+	{
+		for (int player = 0; player < Input::connected; player++)
+		{
+			Input::latched[player] = 0;
+		}
+	}
+
+	/** @brief Get controller port of a player
+	 * @param player Player index
+	 * @return Controller port, -1 if player has no controller
+	 */
+	static int GetPort(int player)
+	{
+		return player >= 0 && player < Input::connected ? Input::ports[player] : -1;
+	}
+
+	/** @brief Get snapshot of a player
+	 * @param player Player index
+	 * @return Held keys in low half and keys down in high half, 0 if player has no controller
+	 */
+	static uint32_t Get(int player)
+	{
+		return player >= 0 && player < Input::connected ? Input::snapshot[player] : 0;
+	}
+
+	/** @brief Get gameplay keys of a player for a simulation tick, keys down are the ones latched since last tick
+	 * @param player Player index
+	 * @return Held keys in low byte and keys down in high byte, 0 if player has no controller
+	 */
+	static uint16_t GetTick(int player)
+	{
+		return player >= 0 && player < Input::connected ? (Input::snapshot[player] & 0x00ff) | Input::latched[player] : 0;
+	}
+
+	/** @brief Is key held
+	 * @param player Player index
+	 * @param key Controller button
+	 * @return True if held
+	 */
+	static bool IsPressed(int player, jo_gamepad_keys key)
+	{
+		return (Input::Get(player) & Input::GetKeyBit(key)) != 0;
+	}
+
+	/** @brief Is key down
+	 * @param player Player index
+	 * @param key Controller button
+	 * @return True if pressed since last frame
+	 */
+	static bool IsDown(int player, jo_gamepad_keys key)
+	{
+		return (Input::Get(player) & ((uint32_t)Input::GetKeyBit(key) << 16)) != 0;
+	}
+};
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <jo/Jo.hpp>
+
+/** @brief Runs batches of simulation work on the slave SH-2 while master builds and draws the frame
+ * @details Jobs must only touch their own objects and read shared state, no allocation, messages or sounds.
+ * Both CPU caches are write-through, so master writes reach memory before the slave starts. Slave purges its cache
+ * before running jobs so it does not see stale lines, and master purges its own cache in Wait() before reading results.
+ * Without dual CPU support jobs are run on the master in Kick().
+ * Only bullet steps are offloaded, they are many and each queries terrain and tile colliders. Other entities either
+ * do a few additions per tick, which costs less than a job, or touch players, sounds and messages, which must stay
+ * on the master.
+ */
+struct JobSystem
+{
+	/** @brief Job entry point
+	 * @param data Job data
+	 * @param first Index of first item to process
+	 * @param count Number of items to process
+	 */
+	using JobFunction = void (*)(void* data, int first, int count);
+
+private:
+	/** @brief Queued job
+	 */
+	struct Job
+	{
+		/** @brief Function to run
+		 */
+		JobFunction Function;
+
+		/** @brief Job data
+		 */
+		void* Data;
+
+		/** @brief Index of first item
+		 */
+		int First;
+
+		/** @brief Number of items
+		 */
+		int Count;
+	};
+
+	/** @brief Maximal number of jobs in a single batch
+	 */
+	static const int MaxJobs = 16;
+
+	/** @brief Jobs of current batch
+	 */
+	inline static Job jobs[JobSystem::MaxJobs];
+
+	/** @brief Number of jobs in current batch
+	 */
+	inline static int jobCount = 0;
+
+	/** @brief Indicates whether batch was handed to the slave and not waited for yet
+	 */
+	inline static bool running = false;
+
+	/** @brief Run all queued jobs on calling CPU
+	 */
+	static void RunAll()
+	{
+		for (int index = 0; index < JobSystem::jobCount; index++)
+		{
+			JobSystem::jobs[index].Function(JobSystem::jobs[index].Data, JobSystem::jobs[index].First, JobSystem::jobs[index].Count);
+		}
+	}
+
+#ifdef JO_COMPILE_WITH_DUAL_CPU_SUPPORT
+	/** @brief Slave entry point
+	 */
+	static void SlaveMain()
+	{
+		// Drop lines cached by earlier batches, master has changed the objects since then
+		slCashPurge();
+		JobSystem::RunAll();
+	}
+#endif
+
+public:
+	/** @brief Queue job for next batch
+	 * @param function Function to run
+	 * @param data Job data
+	 * @param first Index of first item
+	 * @param count Number of items
+	 * @return True if queued, false if batch is full or already running and caller should do the work itself
+	 */
+	static bool Submit(JobFunction function, void* data, int first, int count)
+	{
+		if (JobSystem::running || JobSystem::jobCount >= JobSystem::MaxJobs)
+		{
+			return false;
+		}
+
+		if (count > 0)
+		{
+			JobSystem::jobs[JobSystem::jobCount++] = { function, data, first, count };
+		}
+
+		return true;
+	}
+
+	/** @brief Start queued jobs, master must not touch objects handed to jobs until Wait() returns
+	 */
+	static void Kick()
+	{
+		if (JobSystem::running || JobSystem::jobCount == 0)
+		{
+			return;
+		}
+
+#ifdef JO_COMPILE_WITH_DUAL_CPU_SUPPORT
+		JobSystem::running = true;
+		jo_core_exec_on_slave(JobSystem::SlaveMain);
+#else
+		JobSystem::RunAll();
+		JobSystem::jobCount = 0;
+#endif
+	}
+
+	/** @brief Wait for running jobs to finish, should be called before objects handed to jobs are updated or deleted
+	 */
+	static void Wait()
+	{
+#ifdef JO_COMPILE_WITH_DUAL_CPU_SUPPORT
+		if (JobSystem::running)
+		{
+			// Also purges master cache, so results written by the slave are read from memory
+			jo_core_wait_for_slave();
+			JobSystem::running = false;
+			JobSystem::jobCount = 0;
+		}
+#endif
+	}
+};
@@ -26,15 +26,28 @@ private:
 
     Plane3D plane[PLANE_COUNT];
 
+    Fxp farHeight;      /**< Height of the far plane. */
+    Fxp farWidth;       /**< Width of the far plane. */
     Fxp nearDistance;   /**< Near clipping plane distance. */
     Fxp farDistance;    /**< Far clipping plane distance. */
-    Fxp farWidth;       /**< Width of the far plane. */
-    Fxp farHeight;      /**< Height of the far plane. */
+
+    /**
+     * @brief Get outward normal of a side plane going through the view position.
+     * @param axis View axis the side plane faces.
+     * @param slope Tangent of the half angle on that axis.
+     * @param zAxis The Z-axis of the view matrix.
+     * @return Normalized plane normal.
+     */
+    static Vec3 GetSideNormal(const Vec3& axis, const Fxp& slope, const Vec3& zAxis)
+    {
+        Vec3 normal = axis - (zAxis * slope);
+        return normal / normal.Length();
+    }
 
 public:
     /**
      * @brief Constructor to initialize the frustum.
-     * @param verticalFov Vertical field of view.
+     * @param verticalFov Half of the vertical field of view (in turns, see Trigonometry::DegreesToAngle).
      * @param ratio Aspect ratio.
      * @param nearDistance Near clipping plane distance.
      * @param farDistance Far clipping plane distance.
@@ -57,24 +70,13 @@ public:
      */
     void Update(const Vec3& position, const Vec3& xAxis, const Vec3& yAxis, const Vec3& zAxis)
     {
-        Vec3 farCentre(position + zAxis);
-        Vec3 farHalfHeight(yAxis * farHeight);
-        Vec3 farHalfWidth(yAxis * farWidth);
-
-        Vec3 farTop(farCentre + farHalfHeight);
-        Vec3 farTopLeft(farTop - farHalfWidth);
-        Vec3 farTopRight(farTop + farHalfWidth);
-
-        Vec3 farBottom(farCentre - farHalfHeight);
-        Vec3 farBottomRight(farBottom + farHalfWidth);
-        Vec3 farBottomLeft(farBottom - farHalfWidth);
-
+        // All normals point out of the frustum, so Distance() is positive inside
         plane[PLANE_NEAR] = Plane3D(-zAxis, position + zAxis * nearDistance);
         plane[PLANE_FAR] = Plane3D(zAxis, position + zAxis * farDistance);
-        plane[PLANE_TOP] = Plane3D(farTopRight, position, farTopLeft);
-        plane[PLANE_BOTTOM] = Plane3D(farBottomLeft, position, farBottomRight);
-        plane[PLANE_LEFT] = Plane3D(farTopLeft, position, farBottomLeft);
-        plane[PLANE_RIGHT] = Plane3D(farBottomRight, position, farTopRight);
+        plane[PLANE_TOP] = Plane3D(GetSideNormal(yAxis, farHeight, zAxis), position);
+        plane[PLANE_BOTTOM] = Plane3D(GetSideNormal(-yAxis, farHeight, zAxis), position);
+        plane[PLANE_LEFT] = Plane3D(GetSideNormal(-xAxis, farWidth, zAxis), position);
+        plane[PLANE_RIGHT] = Plane3D(GetSideNormal(xAxis, farWidth, zAxis), position);
     }
 
 
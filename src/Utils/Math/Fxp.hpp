@@ -12,15 +12,21 @@ class Fxp
 private:
     int32_t value; /**< The internal value. */
 
+#ifdef UTE_HOST_BUILD
+    /* Host has no division unit, quotient of last division is kept here */
+    static inline int32_t dvdntl = 0;
+#else
     /* Division related variables */
     static inline constexpr size_t cpuAddress = 0xFFFFF000UL;
     static inline auto& dvsr = *reinterpret_cast<volatile uint32_t*>(cpuAddress + 0x0F00UL);
     static inline auto& dvdnth = *reinterpret_cast<volatile uint32_t*>(cpuAddress + 0x0F10UL);
     static inline auto& dvdntl = *reinterpret_cast<volatile uint32_t*>(cpuAddress + 0x0F14UL);
+#endif
 
     friend class Vec3;
     friend class Trigonometry;
 
+#ifndef UTE_HOST_BUILD
     struct Internal
     {
         int16_t high;
@@ -30,6 +36,7 @@ private:
     };
 
     constexpr Internal& InternalAccess() { return *reinterpret_cast<Internal*>(value); };
+#endif
 
     /**
      * @brief Private constructor for creating Fxp objects from an int32_t value.
@@ -84,7 +91,12 @@ public:
      * @param integerValue The 16-bit integer value.
      * @return The corresponding Fxp object.
      */
+#ifdef UTE_HOST_BUILD
+    // Host is little-endian, halves of the value can not be written directly
+    static constexpr Fxp FromInt(const int16_t& integerValue) { return Fxp(static_cast<int32_t>(integerValue) * 65536); }
+#else
     static constexpr Fxp FromInt(const int16_t& integerValue) { return Internal(integerValue).AsFxp(); }
+#endif
 
     /**
      * @brief Build an Fxp object from a raw 32-bit integer value.
@@ -101,6 +113,14 @@ public:
      */
     static void AsyncDivSet(const Fxp& dividend, const Fxp& divisor)
     {
+#ifdef UTE_HOST_BUILD
+        // Same result as the division unit, overflow and division by zero saturate
+        int64_t quotient = divisor.value != 0 ?
+            (static_cast<int64_t>(dividend.value) * 65536) / divisor.value :
+            (dividend.value < 0 ? INT64_MIN : INT64_MAX);
+
+        dvdntl = quotient > INT32_MAX ? INT32_MAX : (quotient < INT32_MIN ? INT32_MIN : static_cast<int32_t>(quotient));
+#else
         uint32_t dividendh;
         __asm__ volatile("swap.w %[in], %[out]\n"
             : [out] "=&r"(dividendh)
@@ -112,6 +132,7 @@ public:
         dvdnth = dividendh;
         dvsr = divisor.value;
         dvdntl = dividend.value << 16;
+#endif
     }
 
     /**
@@ -230,7 +251,11 @@ public:
      * @brief Convert the fixed-point value to a 16-bit integer value.
      * @return The 16-bit integer representation of the value.
      */
+#ifdef UTE_HOST_BUILD
+    constexpr int16_t ToInt() { return static_cast<int16_t>(value >> 16); }
+#else
     constexpr int16_t ToInt() { return InternalAccess().high; }
+#endif
 
     /**************Operators****************/
 
@@ -263,6 +288,9 @@ public:
         }
         else
         {
+#ifdef UTE_HOST_BUILD
+            value = static_cast<int32_t>((static_cast<int64_t>(value) * fxp.value) >> 16);
+#else
             uint32_t mach;
             __asm__ volatile(
                 "\tdmuls.l %[a], %[b]\n"
@@ -276,6 +304,7 @@ public:
                 : [a] "r" (value),
                 [b] "r" (fxp.value)
                 : "mach", "macl");
+#endif
         }
 
         return *this;
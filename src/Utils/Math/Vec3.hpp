@@ -103,6 +103,13 @@ struct Vec3
         }
         else
         {
+#ifdef UTE_HOST_BUILD
+            int64_t sum = static_cast<int64_t>(x.value) * vec.x.value +
+                static_cast<int64_t>(y.value) * vec.y.value +
+                static_cast<int64_t>(z.value) * vec.z.value;
+
+            return Fxp::BuildRaw(static_cast<int32_t>(sum >> 16));
+#else
             int32_t aux0;
             int32_t aux1;
             auto a = reinterpret_cast<const int32_t*>(this);
@@ -123,6 +130,7 @@ struct Vec3
                 "m"(*b)
                 : "mach", "macl", "memory");
             return aux1;
+#endif
         }
     }
 
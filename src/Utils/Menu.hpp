@@ -2,6 +2,8 @@
 
 #include "Settings.hpp"
 #include "UI.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
 
 namespace UI
 {
@@ -99,6 +101,23 @@ namespace UI
             EndScreenText() : ActionButton(9, 15) {}
         };
 
+        struct WatchReplay : Settings, ActionButton
+        {
+            std::string Text() const { return "Watch Replay"; }
+            void PerformAction()
+            {
+                if (!Replay::HasRecording()) return;
+
+                // Tear down finished match and start it again from the recording
+                Replay::RequestPlayback();
+                currentScreen = Screen::Intro;
+                Settings::Quit = true;
+                Settings::GameEnded = false;
+                Settings::IsActive = true;
+            }
+            WatchReplay() : ActionButton(9, 17) {}
+        };
+
         // Credits menu
         struct ReyMe : Settings, ActionButton
         {
@@ -153,7 +172,7 @@ namespace UI
             new ButtonGroup<ReyMe, DannyDuarte, am25, Random, AnriFox>,
             new ButtonGroup<StageSelector, PlayerCountSelector, TimeLimitSelector, GoToIntro, StartGame>,
             new ButtonGroup<Unpause,Quit>,
-            new ButtonGroup<EndScreenText,Quit>
+            new ButtonGroup<EndScreenText,Quit,WatchReplay>
         };
 
     public:
@@ -161,23 +180,23 @@ namespace UI
         {
             if (!Settings::IsActive)
             {
-                if (jo_is_pad1_key_down(JO_KEY_A))
+                if (Input::IsDown(0, JO_KEY_A))
                 {
                     screens[currentScreen]->HandleMessages(Messages::PerformAction());
                 }
-                if (jo_is_pad1_key_down(JO_KEY_DOWN))
+                if (Input::IsDown(0, JO_KEY_DOWN))
                 {
                     screens[currentScreen]->HandleMessages(Messages::NavigateNext());
                 }
-                if (jo_is_pad1_key_down(JO_KEY_UP))
+                if (Input::IsDown(0, JO_KEY_UP))
                 {
                     screens[currentScreen]->HandleMessages(Messages::NavigatePrevious());
                 }
-                if (jo_is_pad1_key_down(JO_KEY_LEFT))
+                if (Input::IsDown(0, JO_KEY_LEFT))
                 {
                     screens[currentScreen]->HandleMessages(Messages::SelectPrevious());
                 }
-                if (jo_is_pad1_key_down(JO_KEY_RIGHT))
+                if (Input::IsDown(0, JO_KEY_RIGHT))
                 {
                     screens[currentScreen]->HandleMessages(Messages::SelectNext());
                 }
@@ -193,7 +212,7 @@ namespace UI
                 jo_clear_screen();
                 screens[currentScreen]->HandleMessages(Messages::Draw());
 			}
-            else if (Settings::IsActive && jo_is_pad1_key_down(JO_KEY_START))
+            else if (Settings::IsActive && Input::IsDown(0, JO_KEY_START))
             {
                 Settings::IsActive = false;
                 currentScreen = Screen::Pause;
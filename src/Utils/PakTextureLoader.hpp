@@ -30,6 +30,133 @@ private:
 		}
 	};
 
+	/** @brief Average color of each loaded texture
+	 */
+	inline static jo_color averageColors[UTE_MAX_SPRITE] = { JO_COLOR_Transparent };
+
+	/** @brief Maximal number of different texture sizes
+	 */
+	static const int MaxQuadSizes = 24;
+
+	/** @brief Quad vertices of each texture size, shared by all textures of that size
+	 */
+	inline static POINT quadPoints[PakTextureLoader::MaxQuadSizes][4];
+
+	/** @brief Texture size each quad vertex table belongs to
+	 */
+	inline static uint16_t quadSizes[PakTextureLoader::MaxQuadSizes][2];
+
+	/** @brief Number of used quad vertex tables
+	 */
+	inline static int quadSizeCount = 0;
+
+	/** @brief Single polygon shared by all quads
+	 */
+	inline static POLYGON quadPolygon[] = { NORMAL(0, 0, 1), VERTICES(0, 1, 2, 3) };
+
+	/** @brief Quad attribute of each loaded texture
+	 */
+	inline static ATTR quadAttributes[UTE_MAX_SPRITE];
+
+	/** @brief Textured quad of each loaded texture
+	 */
+	inline static PDATA quads[UTE_MAX_SPRITE];
+
+	/** @brief Calculate average color of opaque texture pixels
+	 * @param texture Texture data
+	 * @return Average color
+	 */
+	static jo_color GetAverage(const Texture* texture)
+	{
+		int red = 0;
+		int green = 0;
+		int blue = 0;
+		int count = 0;
+		jo_color* data = texture->Data();
+
+		for (int pixel = 0; pixel < texture->Width * texture->Height; pixel++)
+		{
+			if (data[pixel] != JO_COLOR_Transparent)
+			{
+				red += JO_COLOR_SATURN_GET_R(data[pixel]);
+				green += JO_COLOR_SATURN_GET_G(data[pixel]);
+				blue += JO_COLOR_SATURN_GET_B(data[pixel]);
+				count++;
+			}
+		}
+
+		if (count == 0)
+		{
+			return JO_COLOR_Transparent;
+		}
+
+		return JO_COLOR_SATURN_RGB(red / count, green / count, blue / count);
+	}
+
+	/** @brief Get quad vertices for texture size
+	 * @param width Texture width
+	 * @param height Texture height
+	 * @return Vertex table or nullptr if there are too many texture sizes
+	 */
+	static POINT* GetQuadPoints(const uint16_t width, const uint16_t height)
+	{
+		for (int size = 0; size < PakTextureLoader::quadSizeCount; size++)
+		{
+			if (PakTextureLoader::quadSizes[size][0] == width && PakTextureLoader::quadSizes[size][1] == height)
+			{
+				return PakTextureLoader::quadPoints[size];
+			}
+		}
+
+		if (PakTextureLoader::quadSizeCount >= PakTextureLoader::MaxQuadSizes)
+		{
+			return nullptr;
+		}
+
+		int size = PakTextureLoader::quadSizeCount++;
+		jo_fixed halfWidth = JO_MULT_BY_65536(JO_DIV_BY_2(width));
+		jo_fixed halfHeight = JO_MULT_BY_65536(JO_DIV_BY_2(height));
+		POINT* points = PakTextureLoader::quadPoints[size];
+		PakTextureLoader::quadSizes[size][0] = width;
+		PakTextureLoader::quadSizes[size][1] = height;
+
+		points[0][X] = -halfWidth;
+		points[0][Y] = -halfHeight;
+		points[1][X] = halfWidth;
+		points[1][Y] = -halfHeight;
+		points[2][X] = halfWidth;
+		points[2][Y] = halfHeight;
+		points[3][X] = -halfWidth;
+		points[3][Y] = halfHeight;
+
+		for (int point = 0; point < 4; point++)
+		{
+			JO_ZERO(points[point][Z]);
+		}
+
+		return points;
+	}
+
+	/** @brief Build textured quad used to draw texture in 3D space
+	 * @param spriteIndex Texture index
+	 * @param texture Texture data
+	 */
+	static void BuildQuad(const int spriteIndex, const Texture* texture)
+	{
+		PDATA& quad = PakTextureLoader::quads[spriteIndex];
+		quad.pntbl = PakTextureLoader::GetQuadPoints(texture->Width, texture->Height);
+		quad.nbPoint = 4;
+		quad.pltbl = PakTextureLoader::quadPolygon;
+		quad.nbPolygon = quad.pntbl != nullptr ? 1 : 0;
+		quad.attbl = &PakTextureLoader::quadAttributes[spriteIndex];
+
+		// Same attribute jo engine sets on its own sprite quads
+		quad.attbl->flag = Dual_Plane;
+		JO_ZERO(quad.attbl->gstb);
+		jo_3d_set_texture((jo_3d_quad*)&quad, spriteIndex);
+		jo_3d_set_screen_doors((jo_3d_quad*)&quad, false);
+		jo_3d_set_light((jo_3d_quad*)&quad, false);
+	}
 
 public:
 
@@ -55,6 +182,12 @@ public:
 			jo_img img = { texture->Width, texture->Height, texture->Data() };
 			int32_t spriteIndex = jo_sprite_add(&img);
 
+			if (spriteIndex >= 0 && spriteIndex < UTE_MAX_SPRITE)
+			{
+				PakTextureLoader::averageColors[spriteIndex] = PakTextureLoader::GetAverage(texture);
+				PakTextureLoader::BuildQuad(spriteIndex, texture);
+			}
+
 			if (firstTexture< 0)
 			{
 				firstTexture = spriteIndex;
@@ -64,4 +197,27 @@ public:
 		jo_free(fileBuffer);
 		return firstTexture;
 	}
+
+	/** @brief Get average color of a texture loaded from pak file
+	 * @param texture Texture index
+	 * @return Average color or transparent if texture was not loaded from pak file
+	 */
+	static jo_color GetAverageColor(const int texture)
+	{
+		if (texture >= 0 && texture < UTE_MAX_SPRITE)
+		{
+			return PakTextureLoader::averageColors[texture];
+		}
+
+		return JO_COLOR_Transparent;
+	}
+
+	/** @brief Get textured quad built when texture was loaded from pak file
+	 * @param texture Texture index
+	 * @return Quad centered on origin with size of the texture in world units
+	 */
+	static PDATA* GetSpriteQuad(const int texture)
+	{
+		return &PakTextureLoader::quads[texture];
+	}
 };
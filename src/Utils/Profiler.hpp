@@ -0,0 +1,286 @@
+#pragma once
+
+#include <jo/Jo.hpp>
+
+#include "Debug.hpp"
+#include "Input.hpp"
+
+#ifdef ENABLE_DEBUG
+
+/** @brief Scoped frame profiler, time spent in each named section is kept for the last 256 frames
+ * @details Time is read from the free running counter, which is reset at the start of every frame by
+ * jo_fixed_point_time(), so a scope must not span the start of a frame. Scopes must only run on the master CPU,
+ * slave has its own counter and jobs run on it would race with the master, so code shared with jobs is measured at
+ * its master side caller instead of inside. Sections are looked up by name pointer,
+ * so names should be string literals. Use PROFILE_SCOPE and PROFILE_END_FRAME, they compile to nothing without ENABLE_DEBUG.
+ */
+struct Profiler
+{
+	/** @brief Maximal number of sections
+	 */
+	static const int MaxSections = 16;
+
+	/** @brief Number of frames kept in history, frame index wraps around on its own
+	 */
+	static const int HistoryLength = 256;
+
+	/** @brief Number of one millisecond buckets in run histogram, last one also holds everything slower
+	 */
+	static const int HistogramBuckets = 24;
+
+	/** @brief Time spent in a section over the whole run
+	 */
+	struct Summary
+	{
+		/** @brief Section name
+		 */
+		const char* Name;
+
+		/** @brief Number of frames section ran in
+		 */
+		uint32_t Frames;
+
+		/** @brief Average time per frame in microseconds
+		 */
+		uint32_t Average;
+
+		/** @brief Slowest frame in microseconds
+		 */
+		uint32_t Peak;
+
+		/** @brief Number of frames in each one millisecond bucket
+		 */
+		const uint32_t* Histogram;
+	};
+
+	/** @brief Measures time from construction to end of the enclosing scope
+	 */
+	struct Scope
+	{
+	private:
+		/** @brief Section time is added to, -1 if there is no room for it
+		 */
+		int section;
+
+		/** @brief Counter value at start of the scope
+		 */
+		uint16_t start;
+
+	public:
+		/** @brief Start measuring
+		 * @param name Section name
+		 */
+		Scope(const char* name) : section(Profiler::GetSection(name)), start((uint16_t)jo_time_get_frc())
+		{
+		}
+
+		/** @brief Stop measuring and add elapsed time to current frame
+		 */
+		~Scope()
+		{
+			if (this->section >= 0)
+			{
+				Profiler::Add(this->section, (uint16_t)jo_time_get_frc() - this->start);
+			}
+		}
+	};
+
+private:
+	/** @brief Section names
+	 */
+	inline static const char* names[Profiler::MaxSections];
+
+	/** @brief Number of sections
+	 */
+	inline static int sectionCount = 0;
+
+	/** @brief Counter ticks spent in each section, frame after frame
+	 */
+	inline static uint16_t history[Profiler::HistoryLength][Profiler::MaxSections];
+
+	/** @brief Frame being recorded
+	 */
+	inline static uint8_t frame = 0;
+
+	/** @brief Counter ticks spent in each section over the whole run
+	 */
+	inline static uint32_t totals[Profiler::MaxSections];
+
+	/** @brief Most counter ticks spent in each section in a single frame
+	 */
+	inline static uint32_t peaks[Profiler::MaxSections];
+
+	/** @brief Number of frames each section ran in
+	 */
+	inline static uint32_t sectionFrames[Profiler::MaxSections];
+
+	/** @brief Frames of each section sorted into one millisecond buckets
+	 */
+	inline static uint32_t histogram[Profiler::MaxSections][Profiler::HistogramBuckets];
+
+	/** @brief Counter ticks in one millisecond, depends on clock set up at boot so it is measured on first frame
+	 */
+	inline static uint32_t ticksPerMillisecond = 0;
+
+	static_assert(Profiler::HistoryLength == 256, "Frame index wraps at 256");
+
+	/** @brief Get section by name, new section is added if not found
+	 * @param name Section name
+	 * @return Section index or -1 if all sections are taken
+	 */
+	static int GetSection(const char* name)
+	{
+		for (int section = 0; section < Profiler::sectionCount; section++)
+		{
+			if (Profiler::names[section] == name)
+			{
+				return section;
+			}
+		}
+
+		if (Profiler::sectionCount >= Profiler::MaxSections)
+		{
+			return -1;
+		}
+
+		Profiler::names[Profiler::sectionCount] = name;
+		return Profiler::sectionCount++;
+	}
+
+	/** @brief Add time to section in current frame, sections entered many times a frame add up
+	 * @param section Section index
+	 * @param ticks Elapsed counter ticks
+	 */
+	static void Add(int section, uint16_t ticks)
+	{
+		uint16_t& total = Profiler::history[Profiler::frame][section];
+		total = (uint32_t)total + ticks > 0xffff ? 0xffff : total + ticks;
+	}
+
+public:
+	/** @brief Indicates whether summary is printed every time history fills up, toggled with Y on first controller
+	 */
+	inline static bool Visible = false;
+
+	/** @brief Print min, average and max time in microseconds of each section, frames a section did not run in are skipped
+	 */
+	static void Report()
+	{
+		Debug::LogLine("SECTION     MIN   AVG   MAX");
+
+		for (int section = 0; section < Profiler::sectionCount; section++)
+		{
+			uint32_t minimum = 0xffff;
+			uint32_t maximum = 0;
+			uint32_t total = 0;
+			int frames = 0;
+
+			for (int frame = 0; frame < Profiler::HistoryLength; frame++)
+			{
+				uint32_t ticks = Profiler::history[frame][section];
+
+				if (ticks > 0)
+				{
+					minimum = JO_MIN(minimum, ticks);
+					maximum = JO_MAX(maximum, ticks);
+					total += ticks;
+					frames++;
+				}
+			}
+
+			if (frames > 0)
+			{
+				Debug::LogLine(
+					"%-10s %5d %5d %5d",
+					Profiler::names[section],
+					jo_time_frc_to_microseconds(minimum),
+					jo_time_frc_to_microseconds(total / frames),
+					jo_time_frc_to_microseconds(maximum));
+			}
+		}
+	}
+
+	/** @brief Get number of sections
+	 * @return Number of sections entered so far
+	 */
+	static int GetSectionCount()
+	{
+		return Profiler::sectionCount;
+	}
+
+	/** @brief Get time spent in section over the whole run
+	 * @param section Section index
+	 * @return Section summary
+	 */
+	static Summary GetSummary(int section)
+	{
+		uint32_t frames = JO_MAX(Profiler::sectionFrames[section], 1u);
+
+		return {
+			Profiler::names[section],
+			Profiler::sectionFrames[section],
+			jo_time_frc_to_microseconds(Profiler::totals[section] / frames),
+			jo_time_frc_to_microseconds(Profiler::peaks[section]),
+			Profiler::histogram[section]
+		};
+	}
+
+	/** @brief Move to next frame, should be called once per frame after last section
+	 */
+	static void EndFrame()
+	{
+		if (Input::IsDown(0, JO_KEY_Y))
+		{
+			Profiler::Visible = !Profiler::Visible;
+		}
+
+		if (Profiler::ticksPerMillisecond == 0)
+		{
+			Profiler::ticksPerMillisecond = JO_MAX((1000 * 1000) / JO_MAX(jo_time_frc_to_microseconds(1000), 1u), 1u);
+		}
+
+		for (int section = 0; section < Profiler::sectionCount; section++)
+		{
+			uint32_t ticks = Profiler::history[Profiler::frame][section];
+
+			if (ticks > 0)
+			{
+				Profiler::totals[section] += ticks;
+				Profiler::peaks[section] = JO_MAX(Profiler::peaks[section], ticks);
+				Profiler::sectionFrames[section]++;
+				Profiler::histogram[section][JO_MIN(ticks / Profiler::ticksPerMillisecond, (uint32_t)Profiler::HistogramBuckets - 1)]++;
+			}
+		}
+
+		Profiler::frame++;
+
+		if (Profiler::frame == 0 && Profiler::Visible)
+		{
+			Profiler::Report();
+		}
+
+		for (int section = 0; section < Profiler::MaxSections; section++)
+		{
+			Profiler::history[Profiler::frame][section] = 0;
+		}
+	}
+};
+
+#define PROFILE_JOIN_INNER(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN_INNER(a, b)
+
+/** @brief Measure time until end of the enclosing scope
+ * @param name Section name, string literal
+ */
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILE_JOIN(profileScope, __LINE__)(name)
+
+/** @brief Finish frame of the profiler
+ */
+#define PROFILE_END_FRAME() Profiler::EndFrame()
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_END_FRAME()
+
+#endif
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <jo/Jo.hpp>
+
+#include "..\Interfaces\IRenderable.hpp"
+#include "Math\Frustum.hpp"
+
+/** @brief List of renderable objects visible this frame, sorted by packed key
+ * @details Key is layer (2 bits), depth bucket (14 bits, far to near) and material (16 bits). SGL still Z-sorts
+ * every polygon, the order here decides polygons in the same Z bucket and keeps same material together.
+ */
+struct RenderList
+{
+private:
+	/** @brief Maximal number of tracked objects, same as number of message handler slots
+	 */
+	static const int MaxObjects = 200;
+
+	/** @brief View frustum in world space, bit wider than SGL perspective so objects do not pop in on the screen edge
+	 */
+	inline static Frustum view = Frustum(Trigonometry::DegreesToAngle(40.0), 1.5, 1.0, 512.0);
+
+	/** @brief Size of a depth bucket as shift of view Z (one tile)
+	 */
+	static const int DepthBucketShift = 19;
+
+	/** @brief Largest depth bucket
+	 */
+	static const uint32_t MaxDepthBucket = 0x3fff;
+
+	/** @brief Objects that passed the frustum test
+	 */
+	inline static IRenderable* visible[RenderList::MaxObjects];
+
+	/** @brief Sort key of each visible object
+	 */
+	inline static uint32_t keys[RenderList::MaxObjects];
+
+	/** @brief Radix sort scratch objects
+	 */
+	inline static IRenderable* sortedObjects[RenderList::MaxObjects];
+
+	/** @brief Radix sort scratch keys
+	 */
+	inline static uint32_t sortedKeys[RenderList::MaxObjects];
+
+	/** @brief Number of visible objects
+	 */
+	inline static int visibleCount = 0;
+
+	/** @brief Number of visible objects left out because the list was full, counted since start
+	 */
+	inline static uint32_t droppedCount = 0;
+
+	/** @brief Build sort key of an object
+	 * @param object Renderable object
+	 * @param center Bounding sphere center
+	 * @param hasBounds Whether object has bounding sphere
+	 * @return Packed sort key
+	 */
+	static uint32_t GetKey(IRenderable* object, const Vec3& center, bool hasBounds)
+	{
+		uint32_t bucket = 0;
+
+		if (hasBounds)
+		{
+			FIXED view[XYZ];
+			slCalcPoint(center.x.Value(), center.y.Value(), center.z.Value(), view);
+			bucket = JO_MIN((uint32_t)JO_MAX(view[Z] >> RenderList::DepthBucketShift, 0), RenderList::MaxDepthBucket);
+		}
+
+		// Far objects first
+		return ((uint32_t)object->GetLayer() << 30) | ((RenderList::MaxDepthBucket - bucket) << 16) | object->GetMaterial();
+	}
+
+	/** @brief Sort visible objects by key, least significant byte first
+	 */
+	static void Sort()
+	{
+		IRenderable** objects = RenderList::visible;
+		uint32_t* keys = RenderList::keys;
+		IRenderable** scratchObjects = RenderList::sortedObjects;
+		uint32_t* scratchKeys = RenderList::sortedKeys;
+
+		for (int shift = 0; shift < 32; shift += 8)
+		{
+			uint16_t offsets[256] = { 0 };
+
+			for (int index = 0; index < RenderList::visibleCount; index++)
+			{
+				offsets[(keys[index] >> shift) & 0xff]++;
+			}
+
+			// Skip pass if all objects share this byte
+			if (offsets[(keys[0] >> shift) & 0xff] == RenderList::visibleCount)
+			{
+				continue;
+			}
+
+			uint16_t offset = 0;
+
+			for (uint16_t& count : offsets)
+			{
+				uint16_t bucketSize = count;
+				count = offset;
+				offset += bucketSize;
+			}
+
+			for (int index = 0; index < RenderList::visibleCount; index++)
+			{
+				uint16_t target = offsets[(keys[index] >> shift) & 0xff]++;
+				scratchObjects[target] = objects[index];
+				scratchKeys[target] = keys[index];
+			}
+
+			IRenderable** swapObjects = objects;
+			objects = scratchObjects;
+			scratchObjects = swapObjects;
+
+			uint32_t* swapKeys = keys;
+			keys = scratchKeys;
+			scratchKeys = swapKeys;
+		}
+
+		// Odd number of passes leaves result in scratch arrays
+		if (objects != RenderList::visible)
+		{
+			for (int index = 0; index < RenderList::visibleCount; index++)
+			{
+				RenderList::visible[index] = objects[index];
+				RenderList::keys[index] = keys[index];
+			}
+		}
+	}
+
+public:
+	/** @brief Indicates whether objects outside of the view are skipped
+	 */
+	inline static bool CullingEnabled = true;
+
+	/** @brief Update view frustum from current SGL matrix, should be called once per frame after camera and world transform are set
+	 */
+	static void UpdateView()
+	{
+		MATRIX matrix;
+		slGetMatrix(matrix);
+
+		// Rows of the rotation are world axes in view space, so view axes in world space are its columns
+		Vec3 xAxis(Fxp::BuildRaw(matrix[0][X]), Fxp::BuildRaw(matrix[1][X]), Fxp::BuildRaw(matrix[2][X]));
+		Vec3 yAxis(Fxp::BuildRaw(matrix[0][Y]), Fxp::BuildRaw(matrix[1][Y]), Fxp::BuildRaw(matrix[2][Y]));
+		Vec3 zAxis(Fxp::BuildRaw(matrix[0][Z]), Fxp::BuildRaw(matrix[1][Z]), Fxp::BuildRaw(matrix[2][Z]));
+
+		// View position in world space is the inverse rotated translation
+		const Vec3& translation = (const Vec3&)matrix[3];
+		Vec3 position(
+			-((const Vec3&)matrix[0]).Dot(translation),
+			-((const Vec3&)matrix[1]).Dot(translation),
+			-((const Vec3&)matrix[2]).Dot(translation));
+
+		RenderList::view.Update(position, xAxis, yAxis, zAxis);
+	}
+
+	/** @brief Build sorted list of visible objects, must be called with world matrix set
+	 */
+	static void Build()
+	{
+		RenderList::visibleCount = 0;
+
+		for (auto* object : IRenderable::objects)
+		{
+			Vec3 center;
+			Fxp radius;
+			bool hasBounds = object->GetBoundingSphere(&center, &radius);
+
+			// Frustum takes sphere diameter
+			if (RenderList::CullingEnabled && hasBounds && !RenderList::view.SphereInFrustum(center, radius << 1))
+			{
+				continue;
+			}
+
+			if (RenderList::visibleCount < RenderList::MaxObjects)
+			{
+				RenderList::keys[RenderList::visibleCount] = RenderList::GetKey(object, center, hasBounds);
+				RenderList::visible[RenderList::visibleCount++] = object;
+			}
+			else
+			{
+				RenderList::droppedCount++;
+			}
+		}
+
+		if (RenderList::visibleCount > 1)
+		{
+			RenderList::Sort();
+		}
+	}
+
+	/** @brief Draw all visible objects
+	 */
+	static void Draw()
+	{
+		for (int index = 0; index < RenderList::visibleCount; index++)
+		{
+			RenderList::visible[index]->Draw();
+		}
+	}
+
+	/** @brief Get number of objects drawn this frame
+	 * @return Number of visible objects
+	 */
+	static int GetVisibleCount()
+	{
+		return RenderList::visibleCount;
+	}
+
+	/** @brief Get number of objects culled this frame
+	 * @return Number of objects outside of the view
+	 */
+	static int GetCulledCount()
+	{
+		return (int)IRenderable::objects.size() - RenderList::visibleCount;
+	}
+
+	/** @brief Get number of visible objects that did not fit into the list
+	 * @return Number of dropped objects since start
+	 */
+	static uint32_t GetDroppedCount()
+	{
+		return RenderList::droppedCount;
+	}
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <jo/Jo.hpp>
+
+#include "Debug.hpp"
+#include "FrameGovernor.hpp"
+#include "Input.hpp"
+
+/** @brief Per frame render counters shown in a text overlay, collected only in debug builds
+ */
+struct RenderStats
+{
+private:
+	/** @brief Polygons submitted this frame
+	 */
+	inline static uint32_t polygons = 0;
+
+	/** @brief Sprites submitted this frame
+	 */
+	inline static uint32_t sprites = 0;
+
+	/** @brief Most polygons submitted in a single frame
+	 */
+	inline static uint32_t peakPolygons = 0;
+
+	/** @brief Most sprites submitted in a single frame
+	 */
+	inline static uint32_t peakSprites = 0;
+
+	/** @brief First text line of the overlay, right below debug log
+	 */
+	static const int OverlayLine = Debug::LogLines;
+
+public:
+	/** @brief Indicates whether overlay is shown, toggled with Z on first controller
+	 */
+	inline static bool Visible = false;
+
+	/** @brief Count submitted polygons
+	 * @param count Number of polygons
+	 */
+	static void AddPolygons(uint32_t count)
+	{
+		if constexpr (Debug::Enabled)
+		{
+			RenderStats::polygons += count;
+		}
+	}
+
+	/** @brief Count submitted sprites
+	 * @param count Number of sprites
+	 */
+	static void AddSprites(uint32_t count)
+	{
+		if constexpr (Debug::Enabled)
+		{
+			RenderStats::sprites += count;
+		}
+	}
+
+	/** @brief Get most polygons submitted in a single frame
+	 * @return Number of polygons
+	 */
+	static uint32_t GetPeakPolygons()
+	{
+		return RenderStats::peakPolygons;
+	}
+
+	/** @brief Get most sprites submitted in a single frame
+	 * @return Number of sprites
+	 */
+	static uint32_t GetPeakSprites()
+	{
+		return RenderStats::peakSprites;
+	}
+
+	/** @brief Show counters of this frame and start new frame, should be called once per frame after everything is drawn
+	 * @param visible Number of drawn objects
+	 * @param culled Number of objects outside of the view
+	 */
+	static void Present(int visible, int culled)
+	{
+		if constexpr (Debug::Enabled)
+		{
+			if (Input::IsDown(0, JO_KEY_Z))
+			{
+				RenderStats::Visible = !RenderStats::Visible;
+			}
+
+			if (RenderStats::Visible)
+			{
+#if JO_COMPILE_USING_SGL
+				// SGL does not expose its command list, every polygon and sprite takes one command
+				uint32_t commands = RenderStats::polygons + RenderStats::sprites;
+#else
+				uint32_t commands = jo_vdp1_command_count();
+#endif
+				Debug::Print(0, RenderStats::OverlayLine, "POLY %4d CMD %4d SPR %3d  ", RenderStats::polygons, commands, RenderStats::sprites);
+				Debug::Print(0, RenderStats::OverlayLine + 1, "OBJ %3d CULL %3d VRAM %3d%%  ", visible, culled, jo_sprite_usage_percent());
+				Debug::Print(0, RenderStats::OverlayLine + 2, "SHED %d COST %3d%%  ", FrameGovernor::GetLevel(), FrameGovernor::GetCost());
+			}
+
+			RenderStats::peakPolygons = JO_MAX(RenderStats::peakPolygons, RenderStats::polygons);
+			RenderStats::peakSprites = JO_MAX(RenderStats::peakSprites, RenderStats::sprites);
+			RenderStats::polygons = 0;
+			RenderStats::sprites = 0;
+		}
+	}
+};
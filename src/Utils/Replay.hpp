@@ -0,0 +1,317 @@
+#pragma once
+
+#include <jo/Jo.hpp>
+
+#include "Input.hpp"
+#include "SimulationClock.hpp"
+
+/** @brief Match recording and playback
+ * @details Every match is recorded. Random generator is seeded once per match and gameplay input is taken from a
+ * snapshot made at the start of each simulation tick, so a match replays exactly when the same snapshots are fed back in.
+ * Both recorded and replayed matches read input only through the snapshot.
+ */
+struct Replay
+{
+	/** @brief Maximal number of recorded players
+	 */
+	static const int MaxPlayers = 4;
+
+	/** @brief Scripted input, used instead of live controllers
+	 * @param player Player index
+	 * @param tick Tick of the match
+	 * @return Held keys
+	 */
+	using Script = uint16_t (*)(int player, size_t tick);
+
+private:
+	/** @brief Recorded match
+	 */
+	struct Recording
+	{
+		/** @brief Random seed of the match
+		 */
+		int Seed;
+
+		/** @brief Stage index
+		 */
+		size_t Stage;
+
+		/** @brief Number of players
+		 */
+		size_t PlayerCount;
+
+		/** @brief Match length in seconds
+		 */
+		size_t TotalSeconds;
+
+		/** @brief Number of recorded ticks
+		 */
+		size_t TickCount;
+
+		/** @brief Number of ticks log has room for
+		 */
+		size_t Capacity;
+
+		/** @brief Snapshots tick after tick, one per player, held keys in low byte and keys down in high byte
+		 */
+		uint16_t* Log;
+	};
+
+	/** @brief Last recorded match
+	 */
+	inline static Recording recording = { 1, 0, 0, 0, 0, 0, nullptr };
+
+	/** @brief Input of current tick
+	 */
+	inline static uint16_t snapshot[Replay::MaxPlayers];
+
+	/** @brief Next tick of the match, read from the log when replaying
+	 */
+	inline static size_t cursor = 0;
+
+	/** @brief Input script, nullptr to read live controllers
+	 */
+	inline static Replay::Script script = nullptr;
+
+	/** @brief Indicates whether next match replays the recording
+	 */
+	inline static bool playbackRequested = false;
+
+	/** @brief Indicates whether current match is a replay
+	 */
+	inline static bool playing = false;
+
+	/** @brief Indicates whether a match is running, input comes from the snapshot
+	 */
+	inline static bool active = false;
+
+	/** @brief Get snapshot from input script, keys are down on the tick they start being held
+	 * @param player Player index
+	 * @param tick Tick of the match
+	 * @return Snapshot
+	 */
+	static uint16_t ReadScript(int player, size_t tick)
+	{
+		uint16_t keys = Replay::script(player, tick);
+		uint16_t input = 0;
+
+		for (int bit = 0; bit < Input::TickKeys; bit++)
+		{
+			if ((keys & Input::Keys[bit]) != 0)
+			{
+				input |= 1 << bit;
+
+				if ((Replay::snapshot[player] & (1 << bit)) == 0)
+				{
+					input |= 0x100 << bit;
+				}
+			}
+		}
+
+		return input;
+	}
+
+	/** @brief Mix bits of a value, used to pick scripted moves
+	 * @param value Value to mix
+	 * @return Mixed value
+	 */
+	static uint32_t Hash(uint32_t value)
+	{
+		value ^= value >> 16;
+		value *= 0x7feb352d;
+		value ^= value >> 15;
+		value *= 0x846ca68b;
+		return value ^ (value >> 16);
+	}
+
+public:
+	/** @brief Drive matches from a script instead of live controllers, scripted matches are recorded as usual
+	 * @param function Input script, nullptr to go back to live controllers
+	 */
+	static void SetScript(Replay::Script function)
+	{
+		Replay::script = function;
+	}
+
+	/** @brief Scripted players, walk in a new direction every second or so, shoot often and drop a bomb now and then
+	 * @details Shared by benchmark build and host simulation, so both drive the same matches
+	 * @param player Player index
+	 * @param tick Tick of the match
+	 * @return Held keys
+	 */
+	static uint16_t Wander(int player, size_t tick)
+	{
+		static const jo_gamepad_keys directions[4] = { JO_KEY_UP, JO_KEY_RIGHT, JO_KEY_DOWN, JO_KEY_LEFT };
+		uint32_t offset = tick + (player * 17);
+		uint32_t move = Replay::Hash((offset / 45) * 4 + player);
+		uint16_t keys = directions[move & 3];
+
+		// Diagonal every now and then
+		if ((move & 0x30) == 0)
+		{
+			keys |= directions[(move + 1) & 3];
+		}
+
+		if ((offset % 20) < 2)
+		{
+			keys |= JO_KEY_A;
+		}
+
+		if ((offset % 150) == 0)
+		{
+			keys |= JO_KEY_B;
+		}
+
+		return keys;
+	}
+
+	/** @brief Check whether there is a match to replay
+	 * @return True if recorded
+	 */
+	static bool HasRecording()
+	{
+		return Replay::recording.Log != nullptr && Replay::recording.TickCount > 0;
+	}
+
+	/** @brief Check whether current match is a replay
+	 * @return True if replaying
+	 */
+	static bool IsPlaying()
+	{
+		return Replay::playing;
+	}
+
+	/** @brief Check whether gameplay input comes from the snapshot
+	 * @return True while a match is running
+	 */
+	static bool IsActive()
+	{
+		return Replay::active;
+	}
+
+	/** @brief Replay last recorded match as the next match
+	 */
+	static void RequestPlayback()
+	{
+		Replay::playbackRequested = Replay::HasRecording();
+	}
+
+	/** @brief Start recording or replaying a match, must be called before the world is created
+	 * @param stage Selected stage, replaced by recorded one when replaying
+	 * @param playerCount Number of players, replaced by recorded one when replaying
+	 * @param totalSeconds Match length, replaced by recorded one when replaying
+	 * @param seed Random seed of a recorded match, 0 to take one from the timer
+	 */
+	static void BeginMatch(size_t& stage, size_t& playerCount, size_t& totalSeconds, int seed = 0)
+	{
+		Replay::playing = Replay::playbackRequested;
+		Replay::playbackRequested = false;
+		Replay::active = true;
+		Replay::cursor = 0;
+
+		for (size_t player = 0; player < Replay::MaxPlayers; player++)
+		{
+			Replay::snapshot[player] = 0;
+		}
+
+		if (Replay::playing)
+		{
+			stage = Replay::recording.Stage;
+			playerCount = Replay::recording.PlayerCount;
+			totalSeconds = Replay::recording.TotalSeconds;
+		}
+		else
+		{
+			// Timer counts down by whole ticks, a few extra cover the last frame
+			size_t capacity = ((totalSeconds << 16) / SimulationClock::TickLength) + SimulationClock::MaxTicksPerFrame + 1;
+			delete[] Replay::recording.Log;
+
+			Replay::recording.Seed = seed != 0 ? seed : jo_time_get_frc() + 1;
+			Replay::recording.Stage = stage;
+			Replay::recording.PlayerCount = JO_MIN(playerCount, (size_t)Replay::MaxPlayers);
+			Replay::recording.TotalSeconds = totalSeconds;
+			Replay::recording.TickCount = 0;
+			Replay::recording.Capacity = capacity;
+			Replay::recording.Log = new uint16_t[capacity * Replay::recording.PlayerCount];
+		}
+
+		jo_random_seed = Replay::recording.Seed;
+	}
+
+	/** @brief Stop feeding snapshots, used when the match ends
+	 */
+	static void EndMatch()
+	{
+		Replay::active = false;
+		Replay::playing = false;
+	}
+
+	/** @brief Take input of the next tick, should be called once before each simulation tick
+	 * @param getInput Get live snapshot of a player
+	 */
+	static void BeginTick(uint16_t (*getInput)(int player))
+	{
+		Recording& log = Replay::recording;
+
+		if (Replay::playing)
+		{
+			if (Replay::cursor >= log.TickCount)
+			{
+				// Log ran out, rest of the match stays idle
+				for (size_t player = 0; player < Replay::MaxPlayers; player++)
+				{
+					Replay::snapshot[player] = 0;
+				}
+
+				return;
+			}
+
+			for (size_t player = 0; player < log.PlayerCount; player++)
+			{
+				Replay::snapshot[player] = log.Log[(Replay::cursor * log.PlayerCount) + player];
+			}
+
+			Replay::cursor++;
+			return;
+		}
+
+		for (size_t player = 0; player < log.PlayerCount; player++)
+		{
+			Replay::snapshot[player] = Replay::script != nullptr ?
+				Replay::ReadScript(player, Replay::cursor) :
+				getInput(player);
+		}
+
+		Replay::cursor++;
+
+		if (log.TickCount < log.Capacity)
+		{
+			for (size_t player = 0; player < log.PlayerCount; player++)
+			{
+				log.Log[(log.TickCount * log.PlayerCount) + player] = Replay::snapshot[player];
+			}
+
+			log.TickCount++;
+		}
+	}
+
+	/** @brief Is key held in current snapshot
+	 * @param player Player index
+	 * @param key Controller button
+	 * @return True if held, always false for keys that are not gameplay keys
+	 */
+	static bool IsPressed(int player, jo_gamepad_keys key)
+	{
+		return player >= 0 && player < Replay::MaxPlayers && (Replay::snapshot[player] & Input::GetKeyBit(key) & 0x00ff) != 0;
+	}
+
+	/** @brief Is key down in current snapshot
+	 * @param player Player index
+	 * @param key Controller button
+	 * @return True if pressed since last frame, always false for keys that are not gameplay keys
+	 */
+	static bool IsDown(int player, jo_gamepad_keys key)
+	{
+		return player >= 0 && player < Replay::MaxPlayers && (Replay::snapshot[player] & ((Input::GetKeyBit(key) & 0x00ff) << 8)) != 0;
+	}
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <jo/Jo.hpp>
+
+#include "Math\Vec3.hpp"
+
+/** @brief Fixed timestep clock, simulation runs in whole ticks and drawing interpolates between the last two
+ * @details Entity code keeps reading delta_time, which is set to the tick length for the whole frame.
+ */
+struct SimulationClock
+{
+	/** @brief Simulation rate in ticks per second, follows the video standard
+	 */
+#ifdef JO_PAL_VERSION
+	static const int TicksPerSecond = 50;
+#else
+	static const int TicksPerSecond = 60;
+#endif
+
+	/** @brief Length of a single tick
+	 */
+	static constexpr jo_fixed TickLength = (1 << 16) / SimulationClock::TicksPerSecond;
+
+	/** @brief Most ticks run in a single frame, time above it is dropped so a slow frame does not snowball
+	 */
+	static const int MaxTicksPerFrame = 4;
+
+	/** @brief Run exactly one tick every frame regardless of real time, so each frame does the same work on every run
+	 */
+	inline static bool LockStepEnabled = false;
+
+private:
+	/** @brief Real time not yet simulated
+	 */
+	inline static jo_fixed accumulator = 0;
+
+	/** @brief Fraction of a tick passed since the last simulated tick
+	 */
+	inline static Fxp alpha = 0.0;
+
+public:
+	/** @brief Forget accumulated time, used when a match starts or resumes
+	 */
+	static void Reset()
+	{
+		SimulationClock::accumulator = 0;
+		SimulationClock::alpha = 0.0;
+	}
+
+	/** @brief Take real time of the last frame and get number of ticks to simulate, must be called after jo_fixed_point_time()
+	 * @return Number of ticks to run this frame
+	 */
+	static int BeginFrame()
+	{
+		if (SimulationClock::LockStepEnabled)
+		{
+			SimulationClock::accumulator = 0;
+			SimulationClock::alpha = 0.0;
+			delta_time = SimulationClock::TickLength;
+			return 1;
+		}
+
+		SimulationClock::accumulator += JO_MAX(delta_time, 0);
+		int ticks = SimulationClock::accumulator / SimulationClock::TickLength;
+
+		if (ticks > SimulationClock::MaxTicksPerFrame)
+		{
+			ticks = SimulationClock::MaxTicksPerFrame;
+			SimulationClock::accumulator = 0;
+		}
+		else
+		{
+			SimulationClock::accumulator -= ticks * SimulationClock::TickLength;
+		}
+
+		SimulationClock::alpha = Fxp::BuildRaw(SimulationClock::accumulator) / Fxp::BuildRaw(SimulationClock::TickLength);
+
+		// Everything simulated this frame steps by exactly one tick
+		delta_time = SimulationClock::TickLength;
+		return ticks;
+	}
+
+	/** @brief Get position to draw an object at
+	 * @param previous Position before the last tick
+	 * @param current Position after the last tick
+	 * @return Interpolated position
+	 */
+	static Vec3 Interpolate(const Vec3& previous, const Vec3& current)
+	{
+		return previous + ((current - previous) * SimulationClock::alpha);
+	}
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <jo/Jo.hpp>
+
+#include "Math\Vec3.hpp"
+#include "RenderStats.hpp"
+
+/** @brief Batched billboard sprites, drawn as scaled sprites under the world matrix without any matrix push or pop
+ */
+struct SpriteBatch
+{
+private:
+	/** @brief Maximal number of sprites in a single frame, same as number of message handler slots
+	 */
+	static const int MaxSprites = 200;
+
+	/** @brief Queued sprite
+	 */
+	struct Entry
+	{
+		/** @brief Sprite center and scale (X, Y, Z, S)
+		 */
+		FIXED Position[XYZS];
+
+		/** @brief Sprite index
+		 */
+		uint16_t Texture;
+	};
+
+	/** @brief Sprites queued this frame
+	 */
+	inline static Entry entries[SpriteBatch::MaxSprites];
+
+	/** @brief Number of queued sprites
+	 */
+	inline static int count = 0;
+
+	/** @brief Number of sprites left out because the batch was full, counted since start
+	 */
+	inline static uint32_t droppedCount = 0;
+
+public:
+	/** @brief Queue sprite to be drawn
+	 * @param sprite Sprite index
+	 * @param position Sprite center in world space
+	 * @param scale Sprite scale
+	 */
+	static void Add(int sprite, const Vec3& position, const Fxp& scale)
+	{
+		if (SpriteBatch::count >= SpriteBatch::MaxSprites)
+		{
+			SpriteBatch::droppedCount++;
+			return;
+		}
+
+		Entry& entry = SpriteBatch::entries[SpriteBatch::count++];
+		entry.Position[X] = position.x.Value();
+		entry.Position[Y] = position.y.Value();
+		entry.Position[Z] = position.z.Value();
+		entry.Position[S] = scale.Value();
+		entry.Texture = sprite;
+	}
+
+	/** @brief Draw all queued sprites and clear the batch, must be called with world matrix set
+	 */
+	static void Flush()
+	{
+		// Sprites arrive in render list order, far to near by depth bucket and grouped by texture inside each bucket
+		SPR_ATTR attribute = SPR_ATTRIBUTE(0, No_Palet, No_Gouraud, ECdis, sprNoflip | FUNC_Sprite);
+		int texture = -1;
+
+		for (int index = 0; index < SpriteBatch::count; index++)
+		{
+			Entry& entry = SpriteBatch::entries[index];
+
+			// Attribute is rebuilt only when texture changes
+			if (entry.Texture != texture)
+			{
+				texture = entry.Texture;
+				attribute = SPR_ATTRIBUTE((Uint16)texture, No_Palet, No_Gouraud, ECdis, sprNoflip | FUNC_Sprite);
+
+				if (__jo_sprite_pic[texture].color_mode == COL_32K)
+				{
+					attribute.atrb |= CL32KRGB;
+					attribute.colno = 0;
+				}
+				else
+				{
+					attribute.atrb |= CL256Bnk;
+					attribute.colno = __jo_sprite_attributes.color_table_index;
+				}
+			}
+
+			// SGL transforms center by current matrix and scales sprite by perspective
+			slPutSprite(entry.Position, &attribute, 0);
+		}
+
+		RenderStats::AddSprites(SpriteBatch::count);
+		SpriteBatch::count = 0;
+	}
+
+	/** @brief Get number of sprites that did not fit into the batch
+	 * @return Number of dropped sprites since start
+	 */
+	static uint32_t GetDroppedCount()
+	{
+		return SpriteBatch::droppedCount;
+	}
+};
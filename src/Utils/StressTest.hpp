@@ -0,0 +1,638 @@
+#pragma once
+
+#ifdef STRESS_TEST_MODE
+
+#include <jo/Jo.hpp>
+
+#include "Debug.hpp"
+#include "FrameGovernor.hpp"
+#include "RenderList.hpp"
+#include "Settings.hpp"
+#include "SimulationClock.hpp"
+#include "SpriteBatch.hpp"
+
+#ifdef BENCHMARK_MODE
+#error "Stress test and benchmark builds can not be combined"
+#endif
+
+#ifndef STRESS_STAGE
+#define STRESS_STAGE 0
+#endif
+
+#ifndef STRESS_PLAYERS
+#define STRESS_PLAYERS 2
+#endif
+
+#ifndef STRESS_TYPES
+#define STRESS_TYPES 0x1f
+#endif
+
+#ifndef STRESS_STEP
+#define STRESS_STEP 10
+#endif
+
+#ifndef STRESS_STEP_FRAMES
+#define STRESS_STEP_FRAMES 100
+#endif
+
+#ifndef STRESS_MAX
+#define STRESS_MAX 400
+#endif
+
+static_assert(Debug::Enabled, "Stress test prints through the debug overlay, build it with ENABLE_DEBUG");
+
+/** @brief Entity stress test, boots straight into a match and ramps up each entity type until something gives
+ * @details Population of one entity type is raised by a step every few frames and kept there, entities that die are
+ * spawned again. Each step records frame time and heap usage. Frame time is the whole frame period including wait for
+ * vertical blank, so VDP1 running late counts as much as CPU time. Simulation is locked to one tick per frame, slow
+ * frames do not run extra ticks. Ramp of a type stops at the first hard limit: full message handler table, full render
+ * list or sprite batch, or heap close to full. Knee is the population of the first step in which more than one of ten
+ * frames was dropped, that is took longer than a frame and a half. Sprite slots
+ * (JO_MAX_SPRITE, UTE_MAX_SPRITE) hold textures, entities do not take any, so their usage is only reported once.
+ * Results are printed on screen and kept in StressTest::Results, which starts with "STRS".
+ */
+struct StressTest
+{
+	/** @brief Ramped entity types, bit of each type in STRESS_TYPES follows this order
+	 */
+	enum class Entity
+	{
+		Bullet,
+		Mine,
+		Bomb,
+		Crate,
+		Explosion,
+		Count
+	};
+
+	/** @brief Hard limits
+	 */
+	enum class Limit
+	{
+		/** @brief Ramp ended without hitting a limit
+		 */
+		None,
+
+		/** @brief Message handler table is full, new objects do not get messages
+		 */
+		Handlers,
+
+		/** @brief Render list is full, visible objects are not drawn
+		 */
+		RenderList,
+
+		/** @brief Sprite batch is full, sprites are not drawn
+		 */
+		Sprites,
+
+		/** @brief Heap is close to full, next allocation may fail
+		 */
+		Memory
+	};
+
+	/** @brief Maximal number of steps of a ramp
+	 */
+	static const int MaxSteps = STRESS_MAX / STRESS_STEP;
+
+	static_assert(MaxSteps > 0 && MaxSteps <= 64, "STRESS_MAX / STRESS_STEP must be between 1 and 64");
+
+	/** @brief Single step of a ramp
+	 */
+	struct Step
+	{
+		/** @brief Entities alive at the end of the step
+		 */
+		uint16_t Population;
+
+		/** @brief Average frame period in microseconds
+		 */
+		uint16_t Average;
+
+		/** @brief Longest frame period in microseconds
+		 */
+		uint16_t Peak;
+
+		/** @brief Number of dropped frames
+		 */
+		uint16_t Dropped;
+
+		/** @brief Highest heap usage in percent
+		 */
+		uint8_t MemoryPercent;
+
+		/** @brief Fewest free message handler slots
+		 */
+		uint8_t FreeHandlers;
+	};
+
+	/** @brief Ramp of a single entity type
+	 */
+	struct Ramp
+	{
+		/** @brief Number of recorded steps
+		 */
+		uint32_t StepCount;
+
+		/** @brief Population at which frames start to drop, 0 if they never did
+		 */
+		uint32_t Knee;
+
+		/** @brief First hard limit hit
+		 */
+		Limit HardLimit;
+
+		/** @brief Population at which hard limit was hit
+		 */
+		uint32_t LimitPopulation;
+
+		/** @brief Recorded steps
+		 */
+		Step Steps[StressTest::MaxSteps];
+	};
+
+	/** @brief Results of the run
+	 */
+	struct Report
+	{
+		/** @brief Always "STRS"
+		 */
+		char Magic[4];
+
+		/** @brief Indicates whether run finished, 0 while running
+		 */
+		uint32_t Done;
+
+		/** @brief Number of loaded sprites
+		 */
+		uint32_t SpriteCount;
+
+		/** @brief Sprite VRAM usage in percent
+		 */
+		uint32_t VramPercent;
+
+		/** @brief Ramp of each entity type
+		 */
+		Ramp Ramps[(int)StressTest::Entity::Count];
+	};
+
+	/** @brief Results of the run
+	 */
+	inline static Report Results = { { 'S', 'T', 'R', 'S' } };
+
+private:
+	/** @brief Entity type names
+	 */
+	static constexpr const char* EntityNames[(int)StressTest::Entity::Count] = { "BULLET", "MINE", "BOMB", "CRATE", "EXPLOSION" };
+
+	/** @brief Hard limit names
+	 */
+	static constexpr const char* LimitNames[] = { "-", "HANDLERS", "RENDER", "SPRITES", "MEMORY" };
+
+	/** @brief Frame time budget in microseconds
+	 */
+	static const int FrameBudget = 1000000 / SimulationClock::TicksPerSecond;
+
+	/** @brief Frame period from which frame counts as dropped, vertical blank was missed
+	 */
+	static const uint32_t DroppedPeriod = StressTest::FrameBudget + (StressTest::FrameBudget / 2);
+
+	/** @brief Heap usage in percent at which ramp stops
+	 */
+	static const int MemoryLimitPercent = 90;
+
+	/** @brief Frames at start of a step that are not measured, population has to settle first
+	 */
+	static const int SettleFrames = STRESS_STEP_FRAMES / 4;
+
+	/** @brief Frames between two ramps, lets leftovers of the previous one die out
+	 */
+	static const int CooldownFrames = 60;
+
+	/** @brief Controller of spawned bullets and mines, no player has it
+	 */
+	static const uint8_t NoOwner = 0xff;
+
+	/** @brief Type being ramped
+	 */
+	inline static int entity = -1;
+
+	/** @brief Step of the ramp
+	 */
+	inline static int step = 0;
+
+	/** @brief Frame of the step, negative while cooling down
+	 */
+	inline static int frame = 0;
+
+	/** @brief Population of the type before the ramp started, map crates are not counted
+	 */
+	inline static size_t baseline = 0;
+
+	/** @brief Sum of measured frame times of the step
+	 */
+	inline static uint32_t total = 0;
+
+	/** @brief Number of measured frames of the step
+	 */
+	inline static uint32_t measured = 0;
+
+	/** @brief Render list drops counted when the ramp started
+	 */
+	inline static uint32_t renderDrops = 0;
+
+	/** @brief Sprite batch drops counted when the ramp started
+	 */
+	inline static uint32_t spriteDrops = 0;
+
+	/** @brief Spawn position generator state, kept apart from jo_random so game randomness is not disturbed
+	 */
+	inline static uint32_t random = 0x2545f491;
+
+	/** @brief Get next spawn position random number
+	 * @return Random number
+	 */
+	static uint32_t Next()
+	{
+		StressTest::random ^= StressTest::random << 13;
+		StressTest::random ^= StressTest::random >> 17;
+		StressTest::random ^= StressTest::random << 5;
+		return StressTest::random;
+	}
+
+	/** @brief Get random spawn position above the ground, at least a tile away from the map edge
+	 * @return Spawn position
+	 */
+	static Vec3 GetSpawnPosition()
+	{
+		// Tile is 8 units wide
+		uint32_t value = StressTest::Next();
+		int range = Objects::Map::MapDimensionSize - 2;
+		Vec3 position(
+			Fxp::BuildRaw(((1 + ((value & 0xffff) % range)) << 19) + (value & 0x7ffff)),
+			Fxp::BuildRaw(((1 + ((value >> 16) % range)) << 19) + ((value >> 13) & 0x7ffff)),
+			0.0);
+
+		Objects::Terrain::Ground ground;
+		Objects::Terrain::GetGround(position, &ground);
+		position.z = ground.Height + 1.0;
+		return position;
+	}
+
+	/** @brief Get number of alive entities of a type
+	 * @param type Entity type
+	 * @return Number of alive entities
+	 */
+	static size_t GetPopulation(Entity type)
+	{
+		switch (type)
+		{
+		case Entity::Bullet:
+			return TrackableObject<Entities::Bullet>::objects.size();
+
+		case Entity::Mine:
+			return TrackableObject<Entities::Mine>::objects.size();
+
+		case Entity::Bomb:
+			return TrackableObject<Entities::Bomb>::objects.size();
+
+		case Entity::Crate:
+			return TrackableObject<Entities::Crate>::objects.size();
+
+		case Entity::Explosion:
+			return TrackableObject<Entities::Explosion>::objects.size();
+
+		default:
+			return 0;
+		}
+	}
+
+	/** @brief Spawn single entity at a random position
+	 * @param type Entity type
+	 */
+	static void Spawn(Entity type)
+	{
+		static const Vec3 directions[8] = {
+			Vec3(1.0, 0.0, 0.0), Vec3(0.0, 1.0, 0.0), Vec3(-1.0, 0.0, 0.0), Vec3(0.0, -1.0, 0.0),
+			Vec3(0.7071, 0.7071, 0.0), Vec3(-0.7071, 0.7071, 0.0), Vec3(-0.7071, -0.7071, 0.0), Vec3(0.7071, -0.7071, 0.0)
+		};
+
+		Vec3 position = StressTest::GetSpawnPosition();
+		Vec3 direction = directions[StressTest::Next() & 7];
+
+		switch (type)
+		{
+		case Entity::Bullet:
+			new Entities::Bullet(StressTest::NoOwner, direction, position);
+			break;
+
+		case Entity::Mine:
+			new Entities::Mine(StressTest::NoOwner, position);
+			break;
+
+		case Entity::Bomb:
+			// Dropped in place
+			direction = Vec3();
+			new Entities::Bomb(direction, position);
+			break;
+
+		case Entity::Crate:
+			new Entities::Crate(position, 0x07, 5);
+			break;
+
+		case Entity::Explosion:
+			new Entities::Explosion(position, 0.5);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	/** @brief Delete newest entities of a type, older ones come first in the list
+	 * @tparam T Entity type
+	 * @param count Number of entities to keep
+	 */
+	template <typename T>
+	static void Trim(size_t count)
+	{
+		while (TrackableObject<T>::objects.size() > count)
+		{
+			delete TrackableObject<T>::objects[TrackableObject<T>::objects.size() - 1];
+		}
+	}
+
+	/** @brief Delete entities spawned by the ramp
+	 * @param type Entity type
+	 */
+	static void Clear(Entity type)
+	{
+		switch (type)
+		{
+		case Entity::Bullet:
+			StressTest::Trim<Entities::Bullet>(StressTest::baseline);
+			break;
+
+		case Entity::Mine:
+			StressTest::Trim<Entities::Mine>(StressTest::baseline);
+			break;
+
+		case Entity::Bomb:
+			StressTest::Trim<Entities::Bomb>(StressTest::baseline);
+			break;
+
+		case Entity::Crate:
+			StressTest::Trim<Entities::Crate>(StressTest::baseline);
+			break;
+
+		case Entity::Explosion:
+			StressTest::Trim<Entities::Explosion>(StressTest::baseline);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	/** @brief Get number of free message handler slots
+	 * @return Free slots
+	 */
+	static int GetFreeHandlers()
+	{
+		int free = 0;
+
+		for (IMessageHandler* handler : IMessageHandler::allObjects)
+		{
+			free += handler == nullptr ? 1 : 0;
+		}
+
+		return free;
+	}
+
+	/** @brief Get first hard limit that is hit right now
+	 * @param freeHandlers Free message handler slots
+	 * @param memory Heap usage in percent
+	 * @return Hit limit
+	 */
+	static Limit GetLimit(int freeHandlers, int memory)
+	{
+		if (freeHandlers == 0)
+		{
+			return Limit::Handlers;
+		}
+
+		if (RenderList::GetDroppedCount() != StressTest::renderDrops)
+		{
+			return Limit::RenderList;
+		}
+
+		if (SpriteBatch::GetDroppedCount() != StressTest::spriteDrops)
+		{
+			return Limit::Sprites;
+		}
+
+		if (memory >= StressTest::MemoryLimitPercent)
+		{
+			return Limit::Memory;
+		}
+
+		return Limit::None;
+	}
+
+	/** @brief Move to next selected entity type, or finish if there is none
+	 */
+	static void NextRamp()
+	{
+		do
+		{
+			StressTest::entity++;
+		}
+		while (StressTest::entity < (int)Entity::Count && (STRESS_TYPES & (1 << StressTest::entity)) == 0);
+
+		if (StressTest::entity >= (int)Entity::Count)
+		{
+			StressTest::Finish();
+		}
+
+		StressTest::step = 0;
+		StressTest::frame = -StressTest::CooldownFrames;
+	}
+
+	/** @brief Close current step, ramp ends once a limit is hit or all steps are done
+	 * @param limit Hard limit hit during the step
+	 */
+	static void EndStep(Limit limit)
+	{
+		Entity type = (Entity)StressTest::entity;
+		Ramp& ramp = StressTest::Results.Ramps[StressTest::entity];
+		Step& current = ramp.Steps[StressTest::step];
+		current.Population = StressTest::GetPopulation(type) - StressTest::baseline;
+		current.Average = StressTest::total / JO_MAX(StressTest::measured, 1u);
+		ramp.StepCount = StressTest::step + 1;
+
+		if (ramp.Knee == 0 && current.Dropped * 10 > StressTest::measured)
+		{
+			ramp.Knee = current.Population;
+		}
+
+		if (limit != Limit::None)
+		{
+			ramp.HardLimit = limit;
+			ramp.LimitPopulation = current.Population;
+		}
+
+		StressTest::step++;
+		StressTest::frame = 0;
+		StressTest::total = 0;
+		StressTest::measured = 0;
+
+		if (limit != Limit::None || StressTest::step >= StressTest::MaxSteps)
+		{
+			StressTest::Clear(type);
+			StressTest::NextRamp();
+		}
+	}
+
+	/** @brief Print results and stop
+	 */
+	static void Finish()
+	{
+		Report& report = StressTest::Results;
+		report.SpriteCount = jo_sprite_count();
+		report.VramPercent = jo_sprite_usage_percent();
+
+		jo_clear_screen();
+		jo_printf(0, 0, "STRESS %s %dP STEP %d", Settings::StageNames[Settings::SelectedStage], Settings::PlayerCount, STRESS_STEP);
+		jo_printf(0, 1, "TYPE       KNEE LIMIT      AT  PEAK");
+
+		int line = 2;
+
+		for (int type = 0; type < (int)Entity::Count; type++)
+		{
+			Ramp& ramp = report.Ramps[type];
+
+			if (ramp.StepCount == 0)
+			{
+				continue;
+			}
+
+			uint32_t peak = 0;
+
+			for (uint32_t index = 0; index < ramp.StepCount; index++)
+			{
+				peak = JO_MAX(peak, (uint32_t)ramp.Steps[index].Peak);
+			}
+
+			jo_printf(
+				0,
+				line++,
+				"%-10s %4d %-8s %4d %5d",
+				StressTest::EntityNames[type],
+				ramp.Knee,
+				StressTest::LimitNames[(int)ramp.HardLimit],
+				ramp.LimitPopulation,
+				peak);
+		}
+
+		jo_printf(0, line + 1, "SPRITES %d/%d VRAM %d%%", report.SpriteCount, JO_MIN(JO_MAX_SPRITE, UTE_MAX_SPRITE), report.VramPercent);
+		report.Done = 1;
+
+		while (true)
+		{
+			slSynch();
+		}
+	}
+
+public:
+	/** @brief Set up stress test match, should be called once before main loop
+	 */
+	static void Start()
+	{
+		Settings::SelectedStage = JO_MIN(STRESS_STAGE, Settings::StageCount - 1);
+		Settings::PlayerCount = JO_MAX(JO_MIN(STRESS_PLAYERS, Settings::MaxPlayerCount), (size_t)2);
+		Settings::IsActive = true;
+
+		// Shedding detail would hide the cost being measured, extra ticks of slow frames would add to it
+		FrameGovernor::Enabled = false;
+		SimulationClock::LockStepEnabled = true;
+		StressTest::NextRamp();
+	}
+
+	/** @brief Keep match running, players may die and timer may run out long before the test is done
+	 * @param timeLeft Time left of the match
+	 * @param alive Number of players alive
+	 */
+	static void HoldMatch(Fxp& timeLeft, int& alive)
+	{
+		timeLeft = Fxp::FromInt(Settings::TotalSeconds);
+		alive = Settings::PlayerCount;
+	}
+
+	/** @brief Measure finished frame and spawn entities for the next one, should be called right after synch
+	 * @param inMatch Indicates whether this frame simulated and drew a loaded match
+	 */
+	static void EndFrame(bool inMatch)
+	{
+		if (!inMatch)
+		{
+			return;
+		}
+
+		Entity type = (Entity)StressTest::entity;
+
+		if (StressTest::frame < 0)
+		{
+			// Cooling down, ramp starts from whatever is left alive
+			if (++StressTest::frame == 0)
+			{
+				StressTest::baseline = StressTest::GetPopulation(type);
+				StressTest::renderDrops = RenderList::GetDroppedCount();
+				StressTest::spriteDrops = SpriteBatch::GetDroppedCount();
+			}
+
+			return;
+		}
+
+		// Counter is reset at the start of the frame, after synch it holds the whole frame period
+		uint32_t microseconds = jo_time_frc_to_microseconds(jo_time_get_frc());
+		int freeHandlers = StressTest::GetFreeHandlers();
+		int memory = jo_memory_usage_percent();
+		Step& current = StressTest::Results.Ramps[StressTest::entity].Steps[StressTest::step];
+
+		if (StressTest::frame == 0)
+		{
+			current.Peak = 0;
+			current.Dropped = 0;
+			current.MemoryPercent = 0;
+			current.FreeHandlers = 0xff;
+		}
+
+		if (StressTest::frame >= StressTest::SettleFrames)
+		{
+			StressTest::total += microseconds;
+			StressTest::measured++;
+			current.Peak = JO_MAX(current.Peak, (uint16_t)JO_MIN(microseconds, 0xffffu));
+			current.Dropped += microseconds > StressTest::DroppedPeriod ? 1 : 0;
+		}
+
+		current.MemoryPercent = JO_MAX(current.MemoryPercent, (uint8_t)memory);
+		current.FreeHandlers = JO_MIN(current.FreeHandlers, (uint8_t)freeHandlers);
+
+		Limit limit = StressTest::GetLimit(freeHandlers, memory);
+
+		if (limit != Limit::None || ++StressTest::frame >= STRESS_STEP_FRAMES)
+		{
+			StressTest::EndStep(limit);
+			return;
+		}
+
+		// Keep population at target, entities that died are spawned again
+		size_t target = StressTest::baseline + ((StressTest::step + 1) * STRESS_STEP);
+
+		for (int spawned = 0; spawned < STRESS_STEP && StressTest::GetPopulation(type) < target; spawned++)
+		{
+			StressTest::Spawn(type);
+		}
+	}
+};
+
+#endif
@@ -4,6 +4,8 @@
 #include "std\string.h"
 
 #include "Debug.hpp"
+#include "FrameGovernor.hpp"
+#include "RenderStats.hpp"
 #include "Message.hpp"
 #include "Settings.hpp"
 
@@ -120,26 +122,84 @@ namespace UI
     {
         inline static int headLocations[4][2] = { { 10, 3 }, { 270, 3 }, { 3, 48 }, { 278, 48 } };
 
+        /** @brief Most sprites HUD can show, head, powerup and 6 hearts for each player
+         */
+        static constexpr size_t MaxSprites = 4 * 8;
+
+        /** @brief Sprite emitted by the HUD
+         */
+        struct CachedSprite
+        {
+            uint16_t sprite;
+            int16_t x;
+            int16_t y;
+        };
+
         int32_t playerHealth[4] = { 6, 6, 6, 6 };
         size_t powerupType[4] = { 0, 0, 0, 0 };
 
+        /** @brief Sprites built from current state, emitted once per frame
+         */
+        CachedSprite sprites[MaxSprites];
+        size_t spriteCount = 0;
+
+        /** @brief Number of players sprites were built for
+         */
+        size_t cachedPlayerCount = 0;
+
+        /** @brief Indicates whether state changed since sprites were built
+         */
+        bool dirty = true;
+
+        /** @brief Frames between rebuilds while HUD refresh is shed
+         */
+        static constexpr uint8_t ShedRefreshInterval = 8;
+
+        /** @brief Frames since sprites were last rebuilt
+         */
+        uint8_t framesSinceRebuild = 0;
+
         void HandleMessages(const Message& message)
         {
             if (auto* playerUpdate = message.TryCast<Messages::UpdatePlayer>())
             {
-                playerHealth[playerUpdate->index] = playerUpdate->health;
-                powerupType[playerUpdate->index] = playerUpdate->powerupType;
+                if (playerHealth[playerUpdate->index] != playerUpdate->health ||
+                    powerupType[playerUpdate->index] != playerUpdate->powerupType)
+                {
+                    playerHealth[playerUpdate->index] = playerUpdate->health;
+                    powerupType[playerUpdate->index] = playerUpdate->powerupType;
+                    dirty = true;
+                }
             }
 
             if (auto* timeUpdate = message.TryCast<Messages::UpdateTime>())
             {
+                // Menu clears text layer every frame, so time is printed every time
                 jo_printf(18, 0, "%01d:%02d", timeUpdate->currentTime / 60, timeUpdate->currentTime % 60);
             }
-            Draw();
+
+            if (message.IsType<Messages::Draw>()) { return Draw(); }
         }
 
-        void Draw()
+        /** @brief Rebuild sprites on next draw, used when a new match starts
+         */
+        void Reset()
+        {
+            dirty = true;
+        }
+
+        void Add(int sprite, int x, int y)
+        {
+            if (spriteCount < MaxSprites)
+            {
+                sprites[spriteCount++] = { (uint16_t)sprite, (int16_t)x, (int16_t)y };
+            }
+        }
+
+        void Rebuild()
         {
+            spriteCount = 0;
+            cachedPlayerCount = Settings::PlayerCount;
 
 			for (size_t player = 0; player < Settings::PlayerCount; player++)
 			{
@@ -162,40 +222,67 @@ namespace UI
 				{
 					for(int heart = 0; heart < JO_MIN(playerHealth[player], 3); heart++)
 					{
-						jo_sprite_draw3D2(2, headLocations[player][X] + 38 + (heart * 8), headLocations[player][Y], 50);
+						Add(2, headLocations[player][X] + 38 + (heart * 8), headLocations[player][Y]);
 					}
 
 					for(int heart = 3; heart < playerHealth[player]; heart++)
 					{
-						jo_sprite_draw3D2(2, headLocations[player][X] + 42 + ((heart - 3) * 8), headLocations[player][Y] + 9, 50);
+						Add(2, headLocations[player][X] + 42 + ((heart - 3) * 8), headLocations[player][Y] + 9);
 					}
 				}
 				else if (player == 1 || player == 3)
 				{
 					for(int heart = 0; heart < JO_MIN(playerHealth[player], 3); heart++)
 					{
-						jo_sprite_draw3D2(2, headLocations[player][X] - 4 - (heart * 8), headLocations[player][Y], 50);
+						Add(2, headLocations[player][X] - 4 - (heart * 8), headLocations[player][Y]);
 					}
 
 					for(int heart = 3; heart < playerHealth[player]; heart++)
 					{
-						jo_sprite_draw3D2(2, headLocations[player][X] - 8 - ((heart - 3) * 8), headLocations[player][Y] + 9, 50);
+						Add(2, headLocations[player][X] - 8 - ((heart - 3) * 8), headLocations[player][Y] + 9);
 					}
 				}
 
 				if (powerupType[player] > 0 && (player == 0 || player == 2))
 				{
-					jo_sprite_draw3D2(powerupType[player] - 1, headLocations[player][X] + 40, headLocations[player][Y] + 16, 50);
+					Add(powerupType[player] - 1, headLocations[player][X] + 40, headLocations[player][Y] + 16);
 				}
 				else if (powerupType[player] > 0 && (player == 1 || player == 3))
 				{
-					jo_sprite_draw3D2(powerupType[player] - 1, headLocations[player][X] - 8, headLocations[player][Y] + 16, 50);
+					Add(powerupType[player] - 1, headLocations[player][X] - 8, headLocations[player][Y] + 16);
 				}
 
-				jo_sprite_draw3D2(3 + (player * 4) + offset, headLocations[player][X], headLocations[player][Y], 50);
+				Add(3 + (player * 4) + offset, headLocations[player][X], headLocations[player][Y]);
 			}
+
+            dirty = false;
+            framesSinceRebuild = 0;
         }
 
+        /** @brief Emit HUD sprites, should be sent once per frame with Messages::Draw
+         */
+        void Draw()
+        {
+            if (framesSinceRebuild < ShedRefreshInterval)
+            {
+                framesSinceRebuild++;
+            }
+
+            // While refresh is shed, changes show up a few frames late
+            bool refresh = FrameGovernor::IsEnabled(FrameGovernor::Feature::HudRefresh) || framesSinceRebuild >= ShedRefreshInterval;
+
+            if (cachedPlayerCount != Settings::PlayerCount || (dirty && refresh))
+            {
+                Rebuild();
+            }
+
+            RenderStats::AddSprites(spriteCount);
+
+            for (size_t index = 0; index < spriteCount; index++)
+            {
+                jo_sprite_draw3D2(sprites[index].sprite, sprites[index].x, sprites[index].y, 50);
+            }
+        }
     };
 
     static inline HUD HudHandler;
@@ -2,6 +2,12 @@
 
 #include "utils.h"
 
+#ifdef UTE_HOST_BUILD
+// Host C library declares const correct overloads, which clash with the ones below
+extern "C" {
+#include <string.h>
+}
+#else
 extern "C" {
     int snprintf(char* buffer, size_t n, const char* fmt, ...);
     size_t	strlen(const char* str);
@@ -23,6 +29,7 @@ extern "C" {
     void* memset(void* dst, int ptn, size_t len);
     void* memchr(const void* mem, int ptn, size_t len);
 }
+#endif
 
 namespace std
 {
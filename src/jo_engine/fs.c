@@ -40,6 +40,7 @@
 #include "jo/fs.h"
 #include "jo/tools.h"
 #include "jo/malloc.h"
+#include "jo/time.h"
 
 /** @brief Read retry
  */
@@ -70,16 +71,28 @@
  */
 # define JO_READ_SIZE_ASYNC                       (JO_MAXIMUM_SECTOR_FETCHED_ONCE_ASYNC * JO_SECTOR_SIZE)
 
+/** @brief Time jo_fs_do_background_jobs() may spend reading each frame in microseconds, at least one read is always done
+ */
+#ifndef JO_FS_BACKGROUND_TIME_SLICE
+# define JO_FS_BACKGROUND_TIME_SLICE              (2000)
+#endif
+
 #ifdef JO_COMPILE_WITH_FS_SUPPORT
 
 typedef struct
 {
     bool                        active;
+    jo_fs_priority              priority;
+    unsigned int                sequence;
     jo_fs_async_read_callback   callback;
     GfsHn                       gfs;
+    int                         fid;
+    int                         fad;
+    int                         first_sector;
     int                         file_length;
     char                        *contents;
     char                        *ptr;
+    int                         sectors_left;
     int                         token;
 }                               __jo_fs_background_job;
 
@@ -91,6 +104,9 @@ static GfsDirTbl				__jo_fs_dirtbl;
 static GfsDirName				__jo_fs_dirname[JO_FS_MAX_FILES];
 static __jo_fs_background_job   __jo_fs_background_jobs[JO_MAX_FS_BACKGROUND_JOBS];
 unsigned int                    __jo_fs_background_job_count;
+static unsigned int             __jo_fs_background_job_sequence;
+static int                      __jo_fs_current_background_job;
+static int                      __jo_fs_head_fad;
 static int                      __jo_fs_read_buffer_size = JO_SECTOR_SIZE;
 
 int								jo_fs_init()
@@ -107,6 +123,9 @@ int								jo_fs_init()
     }
 #endif
     JO_ZERO(__jo_fs_background_job_count);
+    JO_ZERO(__jo_fs_background_job_sequence);
+    JO_ZERO(__jo_fs_head_fad);
+    __jo_fs_current_background_job = -1;
     for (JO_ZERO(i); i < JO_MAX_FS_BACKGROUND_JOBS; ++i)
         __jo_fs_background_jobs[i].active = false;
     GFS_DIRTBL_TYPE(&__jo_fs_dirtbl) = GFS_DIR_NAME;
@@ -122,42 +141,140 @@ int								jo_fs_init()
     return (1);
 }
 
-void                    jo_fs_do_background_jobs(void)
+/** @brief Pick next queued job: highest priority first, then the nearest one ahead of the drive head so the
+ *  drive sweeps across the disc instead of seeking back and forth, then the oldest one
+ *  @return Job index, -1 if queue is empty
+ */
+static int              __jo_fs_next_background_job(void)
 {
-    int        i;
-    Sint32              stat;
-    Sint32              nbyte;
+    int                 i;
+    int                 best;
+    bool                ahead;
+    bool                best_ahead;
 
+    best = -1;
+    best_ahead = false;
     for (JO_ZERO(i); i < JO_MAX_FS_BACKGROUND_JOBS; ++i)
     {
         if (!__jo_fs_background_jobs[i].active)
             continue;
-        GFS_NwFread(__jo_fs_background_jobs[i].gfs, JO_MAXIMUM_SECTOR_FETCHED_ONCE_ASYNC, __jo_fs_background_jobs[i].ptr, JO_READ_SIZE_ASYNC);
+        ahead = __jo_fs_background_jobs[i].fad >= __jo_fs_head_fad;
+        if (best >= 0)
+        {
+            if (__jo_fs_background_jobs[i].priority != __jo_fs_background_jobs[best].priority)
+            {
+                if (__jo_fs_background_jobs[i].priority > __jo_fs_background_jobs[best].priority)
+                    continue;
+            }
+            else if (ahead != best_ahead)
+            {
+                if (!ahead)
+                    continue;
+            }
+            else if (__jo_fs_background_jobs[i].fad != __jo_fs_background_jobs[best].fad)
+            {
+                if (__jo_fs_background_jobs[i].fad > __jo_fs_background_jobs[best].fad)
+                    continue;
+            }
+            else if ((int)(__jo_fs_background_jobs[i].sequence - __jo_fs_background_jobs[best].sequence) > 0)
+                continue;
+        }
+        best = i;
+        best_ahead = ahead;
+    }
+    return (best);
+}
+
+/** @brief Open file of a queued job and start reading it
+ *  @param i Job index
+ *  @return true if succeed
+ */
+static bool             __jo_fs_open_background_job(int i)
+{
+    if ((__jo_fs_background_jobs[i].gfs = GFS_Open(__jo_fs_background_jobs[i].fid)) == JO_NULL)
+    {
+#ifdef JO_DEBUG
+        jo_core_error("GFS_Open() failed");
+#endif
+        return (false);
+    }
+    __jo_fs_head_fad = __jo_fs_background_jobs[i].fad;
+    if (__jo_fs_background_jobs[i].first_sector > 0)
+        GFS_Seek(__jo_fs_background_jobs[i].gfs, __jo_fs_background_jobs[i].first_sector, GFS_SEEK_SET);
+    GFS_SetReadPara(__jo_fs_background_jobs[i].gfs, JO_READ_SIZE_ASYNC);
+    GFS_SetTransPara(__jo_fs_background_jobs[i].gfs, JO_MAXIMUM_SECTOR_FETCHED_ONCE_ASYNC);
+    GFS_SetTmode(__jo_fs_background_jobs[i].gfs, GFS_TMODE_SCU);
+    GFS_NwCdRead(__jo_fs_background_jobs[i].gfs, __jo_fs_background_jobs[i].sectors_left * JO_SECTOR_SIZE);
+    return (true);
+}
+
+/** @brief Remove job from the queue and hand its contents to the callback
+ *  @param i Job index
+ *  @param length Length of read data, 0 if read failed
+ */
+static void             __jo_fs_finish_background_job(int i, int length)
+{
+    __jo_fs_background_job  job;
+
+    job = __jo_fs_background_jobs[i];
+    __jo_fs_background_jobs[i].active = false;
+    --__jo_fs_background_job_count;
+    __jo_fs_current_background_job = -1;
+    JO_ZERO(job.contents[length]);
+    /* Slot is free before the callback runs, so it can queue the next read */
+    job.callback(job.contents, length, job.token);
+}
+
+void                    jo_fs_do_background_jobs(void)
+{
+    int                 i;
+    Sint32              stat;
+    Sint32              nbyte;
+    int                 nsct;
+    int                 start;
+
+    start = jo_time_get_frc();
+    do
+    {
+        if (__jo_fs_current_background_job < 0)
+        {
+            if ((i = __jo_fs_next_background_job()) < 0)
+                return;
+            __jo_fs_current_background_job = i;
+            if (!__jo_fs_open_background_job(i))
+            {
+                __jo_fs_finish_background_job(i, 0);
+                continue;
+            }
+        }
+        i = __jo_fs_current_background_job;
+        /* Never fetch past the requested sectors, buffer may be exactly that big */
+        nsct = JO_MIN(__jo_fs_background_jobs[i].sectors_left, JO_MAXIMUM_SECTOR_FETCHED_ONCE_ASYNC);
+        GFS_NwFread(__jo_fs_background_jobs[i].gfs, nsct, __jo_fs_background_jobs[i].ptr, nsct * JO_SECTOR_SIZE);
         do
         {
             GFS_NwExecOne(__jo_fs_background_jobs[i].gfs);
             GFS_NwGetStat(__jo_fs_background_jobs[i].gfs, &stat, &nbyte);
         }
-        while (nbyte < JO_READ_SIZE_ASYNC && stat != GFS_SVR_COMPLETED);
-        if (stat == GFS_SVR_COMPLETED)
+        while (nbyte < nsct * JO_SECTOR_SIZE && stat != GFS_SVR_COMPLETED);
+        __jo_fs_background_jobs[i].sectors_left -= nsct;
+        __jo_fs_head_fad += nsct;
+        if (stat == GFS_SVR_COMPLETED || __jo_fs_background_jobs[i].sectors_left <= 0)
         {
             GFS_Close(__jo_fs_background_jobs[i].gfs);
-            --__jo_fs_background_job_count;
-            JO_ZERO(__jo_fs_background_jobs[i].contents[__jo_fs_background_jobs[i].file_length]);
-            __jo_fs_background_jobs[i].active = false;
-            __jo_fs_background_jobs[i].callback(__jo_fs_background_jobs[i].contents, __jo_fs_background_jobs[i].file_length, __jo_fs_background_jobs[i].token);
+            __jo_fs_finish_background_job(i, __jo_fs_background_jobs[i].file_length);
         }
         else
             __jo_fs_background_jobs[i].ptr += nbyte;
-        return ; //TODO
     }
+    while (jo_time_frc_to_microseconds((unsigned short)(jo_time_get_frc() - start)) < JO_FS_BACKGROUND_TIME_SLICE);
 }
 
-bool                    jo_fs_read_file_async_ptr(const char *const filename, jo_fs_async_read_callback callback, int optional_token, void *buf)
+static bool             __jo_fs_start_background_job(const char *const filename, int first_sector, int sector_count, jo_fs_priority priority, jo_fs_async_read_callback callback, int optional_token, void *buf)
 {
-    int        i;
+    int                 i;
     int			        fid;
-    Sint32			    sctsize;
+    Sint32			    size;
     Sint32              nsct;
     Sint32              lastsize;
 
@@ -180,32 +297,45 @@ bool                    jo_fs_read_file_async_ptr(const char *const filename, jo
 #endif
             return (false);
         }
-        if ((__jo_fs_background_jobs[i].gfs = GFS_Open(fid)) == JO_NULL)
+        /* Size and disc position come from the directory, file is opened once the job is picked */
+        size = __jo_fs_dirname[fid].dirrec.size;
+        nsct = JO_MAX((size + JO_SECTOR_SIZE - 1) / JO_SECTOR_SIZE, 1);
+        lastsize = size - (nsct - 1) * JO_SECTOR_SIZE;
+        __jo_fs_background_jobs[i].first_sector = 0;
+        if (sector_count >= 0)
         {
+            /* Part of the file, last sector of the file can be shorter */
+            sector_count = JO_MIN(sector_count, nsct - first_sector);
+            if (sector_count <= 0)
+            {
 #ifdef JO_DEBUG
-            jo_core_error("%s: GFS_Open() failed", filename);
+                jo_core_error("%s: Sector %d is out of file", filename, first_sector);
 #endif
-            return (false);
+                return (false);
+            }
+            __jo_fs_background_jobs[i].file_length = first_sector + sector_count == nsct ? JO_SECTOR_SIZE * (sector_count - 1) + lastsize : JO_SECTOR_SIZE * sector_count;
+            __jo_fs_background_jobs[i].first_sector = first_sector;
+            nsct = sector_count;
         }
-        GFS_GetFileSize(__jo_fs_background_jobs[i].gfs, &sctsize, &nsct, &lastsize);
-        __jo_fs_background_jobs[i].file_length = (sctsize * (nsct - 1) + lastsize);
+        else
+            __jo_fs_background_jobs[i].file_length = size;
         if (buf != JO_NULL)
             __jo_fs_background_jobs[i].contents = buf;
-        else if ((__jo_fs_background_jobs[i].contents = jo_malloc(sctsize * nsct + 1)) == JO_NULL)
+        else if ((__jo_fs_background_jobs[i].contents = jo_malloc(JO_SECTOR_SIZE * nsct + 1)) == JO_NULL)
         {
 #ifdef JO_DEBUG
             jo_core_error("%s: Out of memory", filename);
 #endif
-            GFS_Close(__jo_fs_background_jobs[i].gfs);
             return (false);
         }
+        __jo_fs_background_jobs[i].priority = priority;
+        __jo_fs_background_jobs[i].sequence = __jo_fs_background_job_sequence++;
+        __jo_fs_background_jobs[i].fid = fid;
+        __jo_fs_background_jobs[i].fad = __jo_fs_dirname[fid].dirrec.fad + __jo_fs_background_jobs[i].first_sector;
         __jo_fs_background_jobs[i].token = optional_token;
         __jo_fs_background_jobs[i].callback = callback;
         __jo_fs_background_jobs[i].ptr = __jo_fs_background_jobs[i].contents;
-        GFS_SetReadPara(__jo_fs_background_jobs[i].gfs, JO_READ_SIZE_ASYNC);
-        GFS_SetTransPara(__jo_fs_background_jobs[i].gfs, JO_MAXIMUM_SECTOR_FETCHED_ONCE_ASYNC);
-        GFS_SetTmode(__jo_fs_background_jobs[i].gfs, GFS_TMODE_SCU);
-        GFS_NwCdRead(__jo_fs_background_jobs[i].gfs, sctsize * nsct);
+        __jo_fs_background_jobs[i].sectors_left = nsct;
         __jo_fs_background_jobs[i].active = true;
         ++__jo_fs_background_job_count;
         return (true);
@@ -216,6 +346,33 @@ bool                    jo_fs_read_file_async_ptr(const char *const filename, jo
     return (false);
 }
 
+bool                    jo_fs_read_file_async_with_priority(const char *const filename, jo_fs_priority priority, jo_fs_async_read_callback callback, int optional_token, void *buf)
+{
+    return (__jo_fs_start_background_job(filename, 0, -1, priority, callback, optional_token, buf));
+}
+
+bool                    jo_fs_read_file_async_ptr(const char *const filename, jo_fs_async_read_callback callback, int optional_token, void *buf)
+{
+    return (__jo_fs_start_background_job(filename, 0, -1, JO_FS_PRIORITY_LEVEL, callback, optional_token, buf));
+}
+
+bool                    jo_fs_read_sectors_async_with_priority(const char *const filename, int first_sector, int sector_count, jo_fs_priority priority, jo_fs_async_read_callback callback, int optional_token, void *buf)
+{
+#ifdef JO_DEBUG
+    if (first_sector < 0 || sector_count <= 0)
+    {
+        jo_core_error("%s: Invalid sector range", filename);
+        return (false);
+    }
+#endif
+    return (__jo_fs_start_background_job(filename, first_sector, sector_count, priority, callback, optional_token, buf));
+}
+
+bool                    jo_fs_read_sectors_async_ptr(const char *const filename, int first_sector, int sector_count, jo_fs_async_read_callback callback, int optional_token, void *buf)
+{
+    return (jo_fs_read_sectors_async_with_priority(filename, first_sector, sector_count, JO_FS_PRIORITY_LEVEL, callback, optional_token, buf));
+}
+
 void			        jo_fs_cd(const char *const sub_dir)
 {
     Sint32			    fid;
@@ -50,9 +50,22 @@
 /*
 ** TYPEDEFS
 */
-/** @brief Function prototype for () */
+/** @brief Function prototype for asynchronous read callbacks
+ *  @warning Length is 0 if the file could not be opened, contents must still be freed if they were allocated by the read
+ */
 typedef void                                (*jo_fs_async_read_callback)(char *contents, int length, int optional_token);
 
+/** @brief Priority of an asynchronous read, queued reads are served from the lowest value up */
+typedef enum
+{
+    /** @brief Data needed as soon as possible while playing, like streamed terrain */
+    JO_FS_PRIORITY_STREAM = 0,
+    /** @brief Level data, default of reads without a priority */
+    JO_FS_PRIORITY_LEVEL = 1,
+    /** @brief Data nobody waits for */
+    JO_FS_PRIORITY_COSMETIC = 2
+}                                           jo_fs_priority;
+
 /** @brief Change the current directory (equivalent of Unix cd command)
  *  @param sub_dir Sub directory name (use JO_PARENT_DIR for parent directory)
  */
@@ -104,6 +117,48 @@ static  __jo_force_inline bool              jo_fs_read_file_async(const char *co
     return (jo_fs_read_file_async_ptr(filename, callback, optional_token, 0));
 }
 
+/** @brief Read part of a file on the CD asynchronously and put the contents to "buf"
+ *  @param filename Filename (upper case and shorter as possible like "A.TXT")
+ *  @param first_sector First sector of the file to read
+ *  @param sector_count Number of sectors to read
+ *  @param callback Callback called when the sectors are loaded
+ *  @param optional_token User value to identify the read
+ *  @param buf Output buffer (at least sector_count * 2048 bytes + 1), allocated with jo_malloc() if null
+ *  @return true if succeed
+ */
+bool                                        jo_fs_read_sectors_async_ptr(const char *const filename, int first_sector, int sector_count, jo_fs_async_read_callback callback, int optional_token, void *buf);
+
+/** @brief Read a file on the CD asynchronously with given priority and put the contents to "buf"
+ *  @param filename Filename (upper case and shorter as possible like "A.TXT")
+ *  @param priority Read priority
+ *  @param callback Callback called when the file is loaded
+ *  @param optional_token User value to identify the file
+ *  @param buf Output buffer, allocated with jo_malloc() if null
+ *  @return true if succeed
+ */
+bool                                        jo_fs_read_file_async_with_priority(const char *const filename, jo_fs_priority priority, jo_fs_async_read_callback callback, int optional_token, void *buf);
+
+/** @brief Read part of a file on the CD asynchronously with given priority and put the contents to "buf"
+ *  @param filename Filename (upper case and shorter as possible like "A.TXT")
+ *  @param first_sector First sector of the file to read
+ *  @param sector_count Number of sectors to read
+ *  @param priority Read priority
+ *  @param callback Callback called when the sectors are loaded
+ *  @param optional_token User value to identify the read
+ *  @param buf Output buffer (at least sector_count * 2048 bytes + 1), allocated with jo_malloc() if null
+ *  @return true if succeed
+ */
+bool                                        jo_fs_read_sectors_async_with_priority(const char *const filename, int first_sector, int sector_count, jo_fs_priority priority, jo_fs_async_read_callback callback, int optional_token, void *buf);
+
+/** @brief Process pending asynchronous reads
+ *  @details Queued reads are served one at a time, highest priority first and then in disc order from the drive
+ *  head. Reading goes on for JO_FS_BACKGROUND_TIME_SLICE microseconds per call. Callbacks are called from here,
+ *  so they run on the calling CPU. A read that started is finished before the next one, whatever its priority.
+ *  Queued reads keep the file id they got when queued, so the current directory must not change until they are done.
+ *  @warning Called by jo_core_run(), call it once per frame if you have your own game loop
+ */
+void                                        jo_fs_do_background_jobs(void);
+
 /** @brief Open a file
  *  @param file Pointer to an allocated jo_file struct
  *  @param filename Filename (upper case and shorter as possible like "A.TXT")
@@ -82,6 +82,12 @@ static  __jo_force_inline void jo_time_set_frc(unsigned char reg)
     jo_time_poke_byte(RegisterLowFRC, reg);
 }
 
+/** @brief Convert Free Running Counter value to microseconds
+ *  @param count Counter value (see jo_time_get_frc())
+ *  @return Time in microseconds
+ */
+unsigned int    jo_time_frc_to_microseconds(int count);
+
 /** @brief get ticks count
  *  @return ticks count from jo_core_run()
  */
@@ -99,6 +99,9 @@ static  __jo_force_inline unsigned short   jo_vdp1_command_to_link(jo_vdp1_comma
 
 jo_vdp1_command*                jo_vdp1_create_command(void);
 
+/** @brief Get number of VDP1 commands created since last reset */
+unsigned int                    jo_vdp1_command_count(void);
+
 #endif
 
 #endif /* !__JO_VDP1_COMMAND_PIPELINE_H__ */
@@ -71,6 +71,11 @@ static  __jo_force_inline int           __jo_time_frame_count_to_mcr(int count)
     return (__jo_time_get_clock_speed() * count * __jo_time_get_clock_mode());
 }
 
+unsigned int                            jo_time_frc_to_microseconds(int count)
+{
+    return (__jo_time_frame_count_to_mcr(count));
+}
+
 unsigned int                            jo_get_ticks(void)
 {
     static unsigned int                 ticks = 0;
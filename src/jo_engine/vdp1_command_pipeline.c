@@ -40,66 +40,80 @@
 #include "jo/math.h"
 #include "jo/tools.h"
 #include "jo/malloc.h"
-#include "jo/list.h"
 #include "jo/vdp1_command_pipeline.h"
 
 #if !JO_COMPILE_USING_SGL
 
-#define JO_COMMAND_TABLE_COUNT   (16)
-#define JO_COMMAND_TABLE_SIZE   (sizeof(jo_vdp1_command) * JO_COMMAND_TABLE_COUNT)
+/* Commands preallocated in each arena, arena grows only when a frame needs more */
+#define JO_VDP1_ARENA_INITIAL_COUNT     (256)
 
 /*
 ** GLOBALS
 */
 
-static jo_list                  __jo_vdp1_buffer;
-static unsigned int             __jo_vdp1_current_table_size = 0;
-static unsigned int             __jo_vdp1_max_runtime_tables = 0;
+/* Two arenas, so next frame can be built while previous one is still being copied */
+static jo_vdp1_command          *__jo_vdp1_arenas[2] = { JO_NULL, JO_NULL };
+static unsigned int             __jo_vdp1_arena_capacity[2] = { 0, 0 };
+static unsigned int             __jo_vdp1_current_arena = 0;
+static unsigned int             __jo_vdp1_command_count = 0;
 
-static jo_vdp1_command          *__jo_create_new_command_table(void)
+static bool                     __jo_vdp1_arena_reserve(unsigned int arena, unsigned int capacity)
 {
-    jo_vdp1_command             *command_table;
+    jo_vdp1_command             *commands;
 
-    if ((command_table = jo_malloc_with_behaviour(JO_COMMAND_TABLE_SIZE, JO_MALLOC_TRY_REUSE_SAME_BLOCK_SIZE)) == JO_NULL)
+    if (capacity <= __jo_vdp1_arena_capacity[arena])
+        return true;
+    if ((commands = jo_malloc(capacity * sizeof(jo_vdp1_command))) == JO_NULL)
     {
 #ifdef JO_DEBUG
         jo_core_error("Out of memory");
 #endif
-        return JO_NULL;
+        return false;
     }
-    jo_list_add_ptr(&__jo_vdp1_buffer, command_table);
-    jo_memset(command_table, 0xFFFF, JO_COMMAND_TABLE_SIZE);
-    JO_ZERO(__jo_vdp1_current_table_size);
-    return command_table;
+    if (__jo_vdp1_arenas[arena] != JO_NULL)
+    {
+        jo_dma_copy(__jo_vdp1_arenas[arena], commands, __jo_vdp1_command_count * sizeof(jo_vdp1_command));
+        jo_free(__jo_vdp1_arenas[arena]);
+    }
+    __jo_vdp1_arenas[arena] = commands;
+    __jo_vdp1_arena_capacity[arena] = capacity;
+    return true;
 }
 
 void                            jo_vdp1_buffer_init(void)
 {
-    jo_list_init(&__jo_vdp1_buffer);
-    __jo_create_new_command_table();
+    __jo_vdp1_arena_reserve(0, JO_VDP1_ARENA_INITIAL_COUNT);
+    __jo_vdp1_arena_reserve(1, JO_VDP1_ARENA_INITIAL_COUNT);
+    JO_ZERO(__jo_vdp1_current_arena);
+    JO_ZERO(__jo_vdp1_command_count);
 }
 
 jo_vdp1_command*                jo_vdp1_create_command(void)
 {
-    jo_vdp1_command             *command_table;
+    jo_vdp1_command             *command;
 
-    if (__jo_vdp1_current_table_size >= JO_COMMAND_TABLE_COUNT)
-        command_table = __jo_create_new_command_table();
-    else
-        command_table = (jo_vdp1_command *)__jo_vdp1_buffer.last->data.ptr;
-    return &command_table[__jo_vdp1_current_table_size++];
+    /* Last slot is kept for the end of list command */
+    if (__jo_vdp1_command_count + 1 >= __jo_vdp1_arena_capacity[__jo_vdp1_current_arena] &&
+        !__jo_vdp1_arena_reserve(__jo_vdp1_current_arena, JO_MULT_BY_2(__jo_vdp1_arena_capacity[__jo_vdp1_current_arena])))
+        return JO_NULL;
+    command = &__jo_vdp1_arenas[__jo_vdp1_current_arena][__jo_vdp1_command_count++];
+    jo_memset(command, 0xFFFF, sizeof(*command));
+    return command;
+}
+
+unsigned int                    jo_vdp1_command_count(void)
+{
+    return __jo_vdp1_command_count;
 }
 
 void                            jo_vdp1_buffer_reset(void)
 {
     jo_vdp1_command             *command_table;
 
-    JO_ZERO(__jo_vdp1_current_table_size);
-    while (__jo_vdp1_buffer.count > 1)
-        jo_list_free_and_remove_last(&__jo_vdp1_buffer);
+    __jo_vdp1_current_arena ^= 1;
+    JO_ZERO(__jo_vdp1_command_count);
     // system clipping
     command_table = jo_vdp1_create_command();
-    jo_memset(command_table, 0xFFFF, JO_COMMAND_TABLE_SIZE);
     command_table->ctrl = SetSystemClipping;
     command_table->xc = JO_TV_WIDTH;
     command_table->yc = JO_TV_HEIGHT;
@@ -117,56 +131,14 @@ void                            jo_vdp1_buffer_reset(void)
     JO_ZERO(command_table->yc);
 }
 
-/*static void                     __jo_vdp1_sort_commands(void)
-{
-    bool                        done;
-    jo_node                     *n;
-#if JO_COMMAND_TABLE_COUNT > (1)
-    int                         i;
-#endif
-    do
-    {
-        done = true;
-        for (n = __jo_vdp1_buffer.first; n->next != JO_NULL; n = n->next)
-        {
-#if JO_COMMAND_TABLE_COUNT > (1)
-
-            for (i = 0; i < JO_COMMAND_TABLE_COUNT; ++i)
-            {
-
-            }
-#else
-            if (((jo_vdp1_command *)n->data.ptr)->jo_engine_reserved < ((jo_vdp1_command *)n->next->data.ptr)->jo_engine_reserved)
-            {
-                done = false;
-                JO_SWAP(n->data.integer, n->next->data.integer);
-            }
-#endif
-        }
-    }
-    while (!done);
-}*/
-
 void                            jo_vdp1_flush(void)
 {
-    jo_node                     *node;
-    unsigned char               *vdp1_vram_addr;
-    int                         fill;
+    jo_vdp1_command             *commands;
 
-    //__jo_vdp1_sort_commands();
-    vdp1_vram_addr = (unsigned char *)JO_VDP1_VRAM;
-    for (node = __jo_vdp1_buffer.first; node != JO_NULL; node = node->next)
-    {
-        jo_dma_copy(node->data.ptr, vdp1_vram_addr, JO_COMMAND_TABLE_SIZE);
-        vdp1_vram_addr += JO_COMMAND_TABLE_SIZE;
-    }
-    if (__jo_vdp1_max_runtime_tables)
-    {
-        fill = __jo_vdp1_max_runtime_tables - __jo_vdp1_buffer.count;
-        if (fill > 0)
-            jo_memset(vdp1_vram_addr, 0xFFFF, JO_COMMAND_TABLE_SIZE * fill);
-    }
-    __jo_vdp1_max_runtime_tables = __jo_vdp1_buffer.count;
+    commands = __jo_vdp1_arenas[__jo_vdp1_current_arena];
+    // end of list, slot is always reserved by jo_vdp1_create_command()
+    jo_memset(&commands[__jo_vdp1_command_count], 0xFFFF, sizeof(*commands));
+    jo_dma_copy(commands, (void *)JO_VDP1_VRAM, (__jo_vdp1_command_count + 1) * sizeof(*commands));
 }
 
 #endif
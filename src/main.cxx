@@ -9,6 +9,17 @@
 #include "Entities\World.hpp"
 #include "Utils\Menu.hpp"
 #include "Utils\Helpers.hpp"
+#include "Utils\Input.hpp"
+#include "Utils\RenderList.hpp"
+#include "Utils\SpriteBatch.hpp"
+#include "Utils\RenderStats.hpp"
+#include "Utils\JobSystem.hpp"
+#include "Utils\SimulationClock.hpp"
+#include "Utils\FrameGovernor.hpp"
+#include "Utils\Profiler.hpp"
+#include "Utils\Replay.hpp"
+#include "Utils\Benchmark.hpp"
+#include "Utils\StressTest.hpp"
 
 #include "Utils\Debug.hpp"
 
@@ -26,6 +37,45 @@ jo_palette* TgaPaletteHandling(void)
 	return (&titleScreen);
 }
 
+/* Finish frame, every frame goes through here including loading ones
+ * @param inMatch Indicates whether this frame simulated and drew a loaded match
+ */
+static void EndFrame(bool inMatch)
+{
+	// Presses made in menus or while loading must not reach the first tick of the match
+	if (!inMatch)
+	{
+		Input::ConsumeDown();
+	}
+
+	{
+		PROFILE_SCOPE("Jobs");
+		JobSystem::Wait();
+	}
+
+	// Everything of this frame is done, what is left of the budget decides detail of the next one
+	FrameGovernor::EndWork();
+
+	{
+		PROFILE_SCOPE("Synch");
+		slSynch();
+	}
+
+	// Measured after synch as well, so frames late because of VDP1 shed detail too
+	FrameGovernor::EndFrame();
+
+	PROFILE_END_FRAME();
+
+#ifdef BENCHMARK_MODE
+	Benchmark::EndFrame(inMatch);
+#endif
+
+#ifdef STRESS_TEST_MODE
+	// Measured after synch, frame period includes waiting for VDP1
+	StressTest::EndFrame(inMatch);
+#endif
+}
+
 int main()
 {
 	jo_core_init(JO_COLOR_Black);
@@ -93,13 +143,29 @@ int main()
 
 	Entities::World* worldPtr = nullptr;
 	Fxp startTime = 0.0;
+
+#ifdef BENCHMARK_MODE
+	Benchmark::Start();
+#endif
+
+#ifdef STRESS_TEST_MODE
+	StressTest::Start();
+#endif
 	
 	while (1)
 	{
 		jo_fixed_point_time();
+		jo_fs_do_background_jobs();
+
+		// Controllers were read during last vertical blank, everything this frame reads the snapshot
+		Input::Update();
 
 		static UI::Menu menu;
-		menu.Update();
+
+		{
+			PROFILE_SCOPE("Menu");
+			menu.Update();
+		}
 
 		if (Settings::Quit && worldPtr)
 		{
@@ -108,6 +174,7 @@ int main()
 			worldPtr = nullptr;
 			Settings::Quit = false;
 			Settings::GameEnded = false;
+			Replay::EndMatch();
 		}
 
 		if (Settings::IsActive)
@@ -116,23 +183,83 @@ int main()
 			if (worldPtr == nullptr)
 			{
 				Settings::GameEnded = false;
-				startTime = Fxp::FromInt(Settings::TotalSeconds);
+
+				// Seeds random generator, so it must come before anything in the world is spawned
+#ifdef BENCHMARK_MODE
+				Replay::BeginMatch(Settings::SelectedStage, Settings::PlayerCount, Settings::TotalSeconds, Benchmark::Seed);
+#else
+				Replay::BeginMatch(Settings::SelectedStage, Settings::PlayerCount, Settings::TotalSeconds);
+#endif
 				worldPtr = new Entities::World(Settings::StageFiles[Settings::SelectedStage]);
-				PoneSound::CD::Play(3, 3, true);
 			}
+
+			if (!worldPtr->IsLoaded())
+			{
+				// Stage is loaded over multiple frames, match starts once it is done
+				if (worldPtr->Load())
+				{
+					startTime = Fxp::FromInt(Settings::TotalSeconds);
+					UI::HudHandler.Reset();
+					SimulationClock::Reset();
+					FrameGovernor::Reset();
+					PoneSound::CD::Play(3, 3, true);
+				}
+				else if (worldPtr->HasFailed())
+				{
+					// Back to menu, same as quitting the match
+					Settings::IsActive = false;
+					Settings::Quit = true;
+					jo_clear_screen();
+					EndFrame(false);
+					continue;
+				}
+				else
+				{
+					jo_printf(16, 14, "Loading %3d%%", worldPtr->GetLoadProgress());
+					EndFrame(false);
+					continue;
+				}
+			}
+
 			slUnitMatrix(0);
 
-			// Update entities
-			for (auto* object : IUpdatable::objects) object->Update();
+			// Update entities in whole simulation ticks, drawing interpolates between last two
+			int ticks = SimulationClock::BeginFrame();
+
+			{
+				PROFILE_SCOPE("Update");
+
+				for (int tick = 0; tick < ticks; tick++)
+				{
+					Replay::BeginTick(Input::GetTick);
+
+					// Press goes to the first tick of the frame only
+					Input::ConsumeDown();
+
+					IUpdatable::UpdateAll();
+				}
+			}
+
+			// Step simulation of the next frame on slave CPU while this one is drawn
+			Entities::Bullet::ScheduleJobs();
+			JobSystem::Kick();
+
+			{
+				PROFILE_SCOPE("Camera");
+				jo_3d_camera_look_at(&camera);
+			}
 
-			jo_3d_camera_look_at(&camera);
 			jo_3d_push_matrix();
 			{
+				PROFILE_SCOPE("Draw");
 				jo_3d_rotate_matrix_rad_x(0.5f);
 				jo_3d_translate_matrix_fixed(-10 << 19, -10 << 19, 0);
 
-				// Draw entities onto the world
-				for (auto* object : IRenderable::objects) object->Draw();
+				// Draw entities onto the world, skip those outside of the view
+				RenderList::UpdateView();
+				RenderList::Build();
+				RenderList::Draw();
+				SpriteBatch::Flush();
 			}
 			jo_3d_pop_matrix();
 
@@ -148,11 +275,16 @@ int main()
 				}
 			}	
 
+#ifdef STRESS_TEST_MODE
+			StressTest::HoldMatch(startTime, alive);
+#endif
+
 			if (startTime <= 0.0 || alive <= 1)
 			{
 				// Show match results
 				Settings::IsActive = false;
 				Settings::GameEnded = true;
+				Replay::EndMatch();
 
 				int winner = 0;
 				int maxHealth = 0;
@@ -174,8 +306,15 @@ int main()
 			else
 			{
 				UI::HudHandler.HandleMessages(UI::Messages::UpdateTime((startTime >> 16).Value()));
-				startTime -= Fxp::BuildRaw(delta_time);
+				startTime -= Fxp::BuildRaw(delta_time * ticks);
+			}
+
+			{
+				PROFILE_SCOPE("HUD");
+				UI::HudHandler.HandleMessages(UI::Messages::Draw());
 			}
+
+			RenderStats::Present(RenderList::GetVisibleCount(), RenderList::GetCulledCount());
 		}
 		else
 		{
@@ -183,7 +322,7 @@ int main()
 		}
 
 
-		slSynch();
+		EndFrame(Settings::IsActive && worldPtr != nullptr && worldPtr->IsLoaded());
 	}
 	return 0;
 }
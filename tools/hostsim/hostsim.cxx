@@ -0,0 +1,382 @@
+/** @file hostsim.cxx
+ *  @brief Host build of the simulation layer
+ *
+ *  Runs matches of the real entity, terrain and message code on a PC, without drawing or sound and as fast
+ *  as the host can go. Used to tune gameplay and to profile the simulation with perf, which is not possible
+ *  on hardware. Players are driven by Replay::Wander, same script as the benchmark build.
+ *
+ *  Usage:
+ *      hostsim <map.ute> [options]
+ *
+ *  Options:
+ *      --players <count>   Number of players (default: 4)
+ *      --ticks <count>     Simulation ticks per match (default: 15000)
+ *      --runs <count>      Number of matches to run one after another (default: 1)
+ *      --seed <value>      Random seed of the first match, next ones count up from it (default: 12345)
+ *
+ *  Each match prints number of ticks, ticks per second and a checksum of player state, so two builds can be
+ *  compared. Results are not bit-exact to hardware, trigonometry comes from libm instead of SGL tables and
+ *  Fxp divides in software.
+ *
+ *  Built with 'make hostsim', which mirrors the game sources with forward slash includes and compiles them
+ *  with UTE_HOST_BUILD against the stubs in tools/hostsim/sgl.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Same order as main.cxx, game headers rely on it. String functions come from utils/std/string.h.
+#include <jo/Jo.hpp>
+#include "Utils/ponesound/ponesound.hpp"
+
+#include "Utils/Math/Vec3.hpp"
+#include "Utils/TrackableObject.hpp"
+
+#include "Utils/Message.hpp"
+#include "Entities/World.hpp"
+#include "Utils/Helpers.hpp"
+#include "Utils/JobSystem.hpp"
+#include "Utils/Replay.hpp"
+#include "Utils/SimulationClock.hpp"
+
+using namespace Objects::LevelFormat;
+
+/** @brief Print error and exit
+ */
+static void Fail(const char* message, const char* detail)
+{
+	fprintf(stderr, "hostsim: %s '%s'\n", message, detail);
+	exit(1);
+}
+
+/** @brief Big-endian reader
+ */
+struct Reader
+{
+	const uint8_t* Data;
+	size_t Size;
+	size_t Offset;
+
+	uint8_t U8()
+	{
+		if (this->Offset >= this->Size)
+		{
+			Fail("unexpected end of file", "");
+		}
+
+		return this->Data[this->Offset++];
+	}
+
+	uint16_t U16()
+	{
+		uint16_t high = this->U8();
+		return (high << 8) | this->U8();
+	}
+
+	uint32_t U32()
+	{
+		uint32_t high = this->U16();
+		return (high << 16) | this->U16();
+	}
+};
+
+/** @brief Read UTE file and decode it into host byte order, so it can be handed to Objects::Map as is
+ * @note Tile depth and rotation bit-fields are unpacked by hand, host bit-field order differs from SH-2
+ * @param name File name
+ * @return Level data followed by entity definitions, same layout as the file on CD
+ */
+static char* LoadUte(const char* name)
+{
+	FILE* file = fopen(name, "rb");
+
+	if (file == nullptr)
+	{
+		Fail("cannot read", name);
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	uint8_t* contents = (uint8_t*)malloc(size);
+
+	if (fread(contents, 1, size, file) != (size_t)size)
+	{
+		Fail("cannot read", name);
+	}
+
+	fclose(file);
+
+	Reader reader = { contents, (size_t)size, 0 };
+	LevelData* level = (LevelData*)calloc(1, size);
+
+	for (unsigned char& byte : level->Identifier) byte = reader.U8();
+
+	if (memcmp(level->Identifier, "UTE", 3) != 0)
+	{
+		Fail("not an UTE file", name);
+	}
+
+	for (Tile& tile : level->TileData)
+	{
+		uint8_t packed = reader.U8();
+		tile.Rotation = packed >> 6;
+		tile.Depth = packed & 0x3f;
+		tile.Texture = reader.U8();
+		tile.Dummy = reader.U16();
+	}
+
+	level->Sun.Direction.X = reader.U32();
+	level->Sun.Direction.Y = reader.U32();
+	level->Sun.Direction.Z = reader.U32();
+	level->Sun.Color = reader.U16();
+	level->Sun.Dummy = reader.U16();
+
+	for (GouraudColor& gouraud : level->Gouraud)
+	{
+		for (uint16_t& color : gouraud.Colors) color = reader.U16();
+	}
+
+	for (Vector& normal : level->Normals)
+	{
+		normal.X = reader.U32();
+		normal.Y = reader.U32();
+		normal.Z = reader.U32();
+	}
+
+	level->EntityCount = reader.U32();
+	EntityDefinition* entities = (EntityDefinition*)(level + 1);
+
+	if (sizeof(LevelData) + (level->EntityCount * sizeof(EntityDefinition)) > (size_t)size)
+	{
+		Fail("entity block does not fit in", name);
+	}
+
+	for (uint32_t index = 0; index < level->EntityCount; index++)
+	{
+		entities[index].Type = reader.U32();
+		entities[index].TileX = reader.U16();
+		entities[index].TileY = reader.U16();
+		entities[index].Direction = reader.U32();
+
+		for (unsigned char& byte : entities[index].Dummy) byte = reader.U8();
+	}
+
+	free(contents);
+	return (char*)level;
+}
+
+/** @brief Spawn map entity, same as Entities::World does on hardware
+ * @param entity Entity definition
+ * @param controller Next free player controller
+ */
+static void SpawnEntity(const Objects::Map::EntityCreationDefinition& entity, uint8_t& controller)
+{
+	switch (entity.Type)
+	{
+	case Objects::Map::EntityType::PlayerSpawn:
+		if (controller < Settings::PlayerCount)
+		{
+			new Entities::Player(entity.Location, entity.Angle, controller++);
+		}
+
+		break;
+
+	case Objects::Map::EntityType::Model:
+		// Models are only drawn, collider is all simulation needs
+		Entities::StaticDetail3D::AddCollider(entity.Location);
+		break;
+
+	case Objects::Map::EntityType::Crate:
+		new Entities::Crate(entity.Location, (unsigned char)entity.Reserved[0], (unsigned short)entity.Reserved[1]);
+		break;
+
+	default:
+		break;
+	}
+}
+
+/** @brief No controllers are connected on host
+ * @param player Player index
+ * @return Always empty snapshot
+ */
+static uint16_t NoController(int player)
+{
+	return 0;
+}
+
+/** @brief Mix value into checksum
+ * @param hash Checksum
+ * @param value Value to mix in
+ * @return New checksum
+ */
+static uint32_t Mix(uint32_t hash, int32_t value)
+{
+	return (hash ^ (uint32_t)value) * 16777619u;
+}
+
+/** @brief Run single match
+ * @param stream Decoded map file
+ * @param seed Random seed
+ * @param tickCount Number of ticks to simulate
+ * @param ticks Number of simulated ticks
+ * @return State checksum
+ */
+static uint32_t RunMatch(char* stream, int seed, size_t tickCount, size_t* ticks)
+{
+	size_t stage = 0;
+	size_t totalSeconds = (tickCount / SimulationClock::TicksPerSecond) + 1;
+	Replay::BeginMatch(stage, Settings::PlayerCount, totalSeconds, seed);
+
+	Objects::Map* map = new Objects::Map(stream, 0);
+	Objects::Terrain::Map = map;
+	Objects::Terrain::ClearColliders();
+
+	uint8_t controller = 0;
+
+	for (int entity = 0; entity < map->EntityDefinitionsCount; entity++)
+	{
+		SpawnEntity(map->EntityDefinitions[entity], controller);
+	}
+
+	SimulationClock::Reset();
+	delta_time = SimulationClock::TickLength;
+	*ticks = 0;
+
+	while (*ticks < tickCount)
+	{
+		Replay::BeginTick(NoController);
+
+		IUpdatable::UpdateAll();
+
+		// Jobs run right away without dual CPU support
+		Entities::Bullet::ScheduleJobs();
+		JobSystem::Kick();
+		JobSystem::Wait();
+		(*ticks)++;
+
+		int alive = 0;
+
+		for (auto* object : TrackableObject<Entities::Player>::objects)
+		{
+			alive += object->GetHealth() > 0 ? 1 : 0;
+		}
+
+		if (alive <= 1)
+		{
+			break;
+		}
+	}
+
+	uint32_t hash = 2166136261u;
+
+	for (auto* object : TrackableObject<Entities::Player>::objects)
+	{
+		const Vec3& position = object->GetPosition();
+		hash = Mix(hash, position.x.Value());
+		hash = Mix(hash, position.y.Value());
+		hash = Mix(hash, position.z.Value());
+		hash = Mix(hash, object->GetHealth());
+	}
+
+	Replay::EndMatch();
+
+	for (auto* object : IRenderable::objects) delete object;
+
+	Objects::Terrain::Map = nullptr;
+	delete map;
+	return hash;
+}
+
+/** @brief Get monotonic time
+ * @return Time in seconds
+ */
+static double Now()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+int main(int argc, char** argv)
+{
+	const char* input = nullptr;
+	size_t tickCount = 15000;
+	int runs = 1;
+	int seed = 12345;
+	Settings::PlayerCount = 4;
+
+	for (int arg = 1; arg < argc; arg++)
+	{
+		// Value of an option, JO_MIN and JO_MAX evaluate their arguments twice
+		int value = arg + 1 < argc ? atoi(argv[arg + 1]) : 0;
+
+		if (strcmp(argv[arg], "--players") == 0 && arg + 1 < argc)
+		{
+			Settings::PlayerCount = JO_MIN(JO_MAX(value, 2), Replay::MaxPlayers);
+			arg++;
+		}
+		else if (strcmp(argv[arg], "--ticks") == 0 && arg + 1 < argc)
+		{
+			tickCount = JO_MAX(value, 1);
+			arg++;
+		}
+		else if (strcmp(argv[arg], "--runs") == 0 && arg + 1 < argc)
+		{
+			runs = JO_MAX(value, 1);
+			arg++;
+		}
+		else if (strcmp(argv[arg], "--seed") == 0 && arg + 1 < argc)
+		{
+			// Zero would make Replay pick a seed from the timer
+			seed = JO_MAX(value, 1);
+			arg++;
+		}
+		else if (argv[arg][0] != '-' && input == nullptr)
+		{
+			input = argv[arg];
+		}
+		else
+		{
+			Fail("unknown option", argv[arg]);
+		}
+	}
+
+	if (input == nullptr)
+	{
+		fprintf(stderr, "usage: hostsim <map.ute> [--players <count>] [--ticks <count>] [--runs <count>] [--seed <value>]\n");
+		return 1;
+	}
+
+	char* stream = LoadUte(input);
+	Objects::Terrain::InitColliders();
+	IMessageHandler::Init();
+	Replay::SetScript(Replay::Wander);
+
+	size_t totalTicks = 0;
+	double start = Now();
+
+	for (int run = 0; run < runs; run++)
+	{
+		size_t ticks;
+		double matchStart = Now();
+		uint32_t hash = RunMatch(stream, seed + run, tickCount, &ticks);
+		double elapsed = Now() - matchStart;
+		totalTicks += ticks;
+
+		printf(
+			"match %d seed %d: %zu ticks, %.0f ticks/s (%.0fx real time), checksum %08x\n",
+			run,
+			seed + run,
+			ticks,
+			ticks / elapsed,
+			ticks / elapsed / SimulationClock::TicksPerSecond,
+			hash);
+	}
+
+	double elapsed = Now() - start;
+	printf("total: %zu ticks in %.3f s, %.0f ticks/s\n", totalTicks, elapsed, totalTicks / elapsed);
+
+	free(stream);
+	return 0;
+}
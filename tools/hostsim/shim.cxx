@@ -0,0 +1,164 @@
+/** @file shim.cxx
+ *  @brief Host stand-ins for the jo engine, SGL and PoneSound functions used by the simulation layer
+ *
+ *  Drawing, DMA and sound do nothing. Memory comes from the host heap, random numbers use the same generator
+ *  as jo engine and SGL trigonometry is computed with libm. No controllers are connected.
+ */
+#include <math.h>
+#include <stdlib.h>
+
+// Plain C header, Jo.hpp placement new clashes with the one host math.h brings in
+extern "C" {
+#include <jo/jo.h>
+}
+
+#include "Utils/ponesound/ponesound.hpp"
+
+extern "C"
+{
+	/*
+	 * jo engine
+	 */
+
+	jo_fixed delta_time = 0;
+	int jo_random_seed = 1;
+	char __jo_sprintf_buf[JO_PRINTF_BUF_SIZE];
+	jo_pos3D __jo_sprite_pos;
+	jo_texture_definition __jo_sprite_def[JO_MAX_SPRITE];
+
+	/** @brief All ports are disconnected, keys are active low
+	 */
+	PerDigital jo_inputs[JO_INPUT_MAX_DEVICE] = {
+		{ PER_ID_NotConnect, 0, 0xffff }, { PER_ID_NotConnect, 0, 0xffff }, { PER_ID_NotConnect, 0, 0xffff },
+		{ PER_ID_NotConnect, 0, 0xffff }, { PER_ID_NotConnect, 0, 0xffff }, { PER_ID_NotConnect, 0, 0xffff },
+		{ PER_ID_NotConnect, 0, 0xffff }, { PER_ID_NotConnect, 0, 0xffff }, { PER_ID_NotConnect, 0, 0xffff },
+		{ PER_ID_NotConnect, 0, 0xffff }, { PER_ID_NotConnect, 0, 0xffff }, { PER_ID_NotConnect, 0, 0xffff }
+	};
+
+	void* jo_malloc_with_behaviour(unsigned int n, const jo_malloc_behaviour behaviour)
+	{
+		return malloc(n);
+	}
+
+	void jo_free(const void* const p)
+	{
+		free((void*)p);
+	}
+
+	/** @brief Park-Miller generator, same as jo engine math.c so seeded matches pick the same numbers
+	 */
+	int jo_random(int max)
+	{
+		const int a = 16807;
+		const int m = 2147483647;
+		const int q = m / a;
+		const int r = m % a;
+
+		jo_random_seed = a * (jo_random_seed % q) - r * (jo_random_seed / q);
+
+		if (jo_random_seed <= 0)
+		{
+			jo_random_seed += m;
+		}
+
+		return jo_random_seed % max + 1;
+	}
+
+	void jo_print(int x, int y, char* str)
+	{
+	}
+
+	void jo_sprite_draw(const int sprite_id, const jo_pos3D* const pos, const bool centered_style_coordinates, const bool billboard)
+	{
+	}
+
+	bool jo_fs_read_sectors_async_with_priority(
+		const char* const filename,
+		int first_sector,
+		int sector_count,
+		jo_fs_priority priority,
+		jo_fs_async_read_callback callback,
+		int optional_token,
+		void* buf)
+	{
+		// There is no CD, maps are always loaded whole
+		return false;
+	}
+
+	/*
+	 * SGL
+	 */
+
+	FIXED slSin(ANGLE angle)
+	{
+		return (FIXED)(sin((Uint16)angle * (2.0 * M_PI / 65536.0)) * 65536.0);
+	}
+
+	FIXED slCos(ANGLE angle)
+	{
+		return (FIXED)(cos((Uint16)angle * (2.0 * M_PI / 65536.0)) * 65536.0);
+	}
+
+	void slCalcPoint(FIXED x, FIXED y, FIXED z, FIXED* result)
+	{
+		// Matrix stack is not kept, points stay where they are
+		result[X] = x;
+		result[Y] = y;
+		result[Z] = z;
+	}
+
+	Bool slPushMatrix(void)
+	{
+		return 1;
+	}
+
+	Bool slPopMatrix(void)
+	{
+		return 1;
+	}
+
+	void slRotX(ANGLE angle)
+	{
+	}
+
+	void slRotY(ANGLE angle)
+	{
+	}
+
+	void slRotZ(ANGLE angle)
+	{
+	}
+
+	void slScale(FIXED x, FIXED y, FIXED z)
+	{
+	}
+
+	void slTranslate(FIXED x, FIXED y, FIXED z)
+	{
+	}
+
+	void slLight(VECTOR direction)
+	{
+	}
+
+	Bool slPutPolygon(PDATA* polygon)
+	{
+		return 1;
+	}
+
+	void slDMACopy(void* source, void* destination, Uint32 size)
+	{
+	}
+
+	void slDMAWait(void)
+	{
+	}
+}
+
+/*
+ * PoneSound
+ */
+
+void PoneSound::Sound::Play(const short sound, const PoneSound::PlayMode mode, const unsigned char volume)
+{
+}
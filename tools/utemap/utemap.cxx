@@ -0,0 +1,1242 @@
+/** @file utemap.cxx
+ *  @brief Host tool for UTE level files
+ *
+ *  Compiles readable level source into UTE, decodes UTE back to source and checks
+ *  baked normals, baked lighting and frame budgets before a map reaches hardware.
+ *
+ *  Usage:
+ *      utemap decode <map.ute> [-o <map.txt>]
+ *      utemap compile <map.txt> -o <map.ute> [--rebake] [--force] [budget options]
+ *      utemap check <map.ute> [budget options]
+ *      utemap pack <map.ute> -o <map.utc>
+ *
+ *  Budget options:
+ *      --models <dir>              Directory with NYA models used to count polygons (default: cd)
+ *      --max-polygons <count>      Polygons drawn per frame (default: 1200)
+ *      --max-colliders <count>     Static tile colliders (default: 100)
+ *      --max-handlers <count>      Message handler slots used by map entities (default: 150)
+ *      --max-players <count>       Player spawns (default: 12)
+ *      --normal-tolerance <deg>    Allowed difference from terrain geometry (default: 6)
+ *      --light-tolerance <steps>   Allowed difference of a gouraud channel (default: 4)
+ *
+ *  Chunk pack (.UTC) holds full detail terrain of each chunk in its own CD sector, the game
+ *  streams terrain from it instead of keeping the whole map mesh in memory when it sits
+ *  next to the map file.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../src/Objects/LevelFormat.hpp"
+
+using namespace Objects;
+
+/** @brief Entity types, must match Objects::Map::EntityType
+ */
+enum EntityType
+{
+	Empty = 0,
+	PlayerSpawn,
+	Model,
+	Crate
+};
+
+/** @brief Entity type names used in level source
+ */
+static const char* EntityTypeNames[] = { "empty", "player", "model", "crate" };
+
+/** @brief Models loaded by the game in ModelManager order
+ */
+static const char* ModelFiles[] = { "CRATE.NYA", "PLAYER.NYA", "TREE.NYA", "WALL.NYA", "WALL2.NYA", "WALL3.NYA", "BOMB.NYA" };
+
+/** @brief Model index of the crate
+ */
+static const int CrateModel = 0;
+
+/** @brief Model index of the player
+ */
+static const int PlayerModel = 1;
+
+/** @brief Message handler slots taken by each spawned entity type (one per TrackableObject base)
+ */
+static const int HandlerSlots[] = { 0, 4, 2, 3 };
+
+/** @brief Loaded level
+ */
+struct Level
+{
+	/** @brief Level header
+	 */
+	LevelFormat::LevelData Data;
+
+	/** @brief Entities following the header
+	 */
+	std::vector<LevelFormat::EntityDefinition> Entities;
+};
+
+/** @brief Check limits
+ */
+struct Budget
+{
+	/** @brief Directory with model files
+	 */
+	std::string ModelDirectory = "cd";
+
+	/** @brief Polygons drawn per frame
+	 */
+	int MaxPolygons = 1200;
+
+	/** @brief Static tile colliders
+	 */
+	int MaxColliders = 100;
+
+	/** @brief Message handler slots, game has 200 in total and needs some for HUD and projectiles
+	 */
+	int MaxHandlers = 150;
+
+	/** @brief Player spawns
+	 */
+	int MaxPlayers = 12;
+
+	/** @brief Allowed angle between baked normal and terrain geometry in degrees
+	 */
+	double NormalTolerance = 6.0;
+
+	/** @brief Allowed difference of a single gouraud color channel
+	 */
+	int LightTolerance = 4;
+};
+
+/** @brief Simple vector used for baking
+ */
+struct Vector
+{
+	double X = 0.0;
+	double Y = 0.0;
+	double Z = 0.0;
+
+	Vector operator+(const Vector& other) const { return { X + other.X, Y + other.Y, Z + other.Z }; }
+	Vector operator-(const Vector& other) const { return { X - other.X, Y - other.Y, Z - other.Z }; }
+	double Dot(const Vector& other) const { return (X * other.X) + (Y * other.Y) + (Z * other.Z); }
+	double Length() const { return std::sqrt(this->Dot(*this)); }
+
+	Vector Cross(const Vector& other) const
+	{
+		return { (Y * other.Z) - (Z * other.Y), (Z * other.X) - (X * other.Z), (X * other.Y) - (Y * other.X) };
+	}
+
+	Vector Normalized() const
+	{
+		double length = this->Length();
+		return length > 0.0 ? Vector { X / length, Y / length, Z / length } : *this;
+	}
+};
+
+/** @brief Print error and exit
+ * @param format Message format
+ */
+template<typename... Args>
+[[noreturn]] static void Fail(const char* format, Args... args)
+{
+	std::fprintf(stderr, "utemap: ");
+	std::fprintf(stderr, format, args...);
+	std::fprintf(stderr, "\n");
+	std::exit(2);
+}
+
+/** @brief Convert 16.16 fixed point number to double
+ */
+static double FromFixed(int32_t value)
+{
+	return value / 65536.0;
+}
+
+/** @brief Convert double to 16.16 fixed point number
+ */
+static int32_t ToFixed(double value)
+{
+	return (int32_t)std::lround(value * 65536.0);
+}
+
+/** @brief Get tile index from location
+ */
+static int GetTileIndex(int x, int y)
+{
+	return x + (y * LevelFormat::MapDimensionSize);
+}
+
+/** @brief Get tile depth with coordinates clamped to the map
+ */
+static int GetDepth(const Level& level, int x, int y)
+{
+	x = std::min(std::max(x, 0), LevelFormat::MapDimensionSize - 1);
+	y = std::min(std::max(y, 0), LevelFormat::MapDimensionSize - 1);
+	return level.Data.TileData[GetTileIndex(x, y)].Depth;
+}
+
+/*
+ * File IO
+ */
+
+/** @brief Read whole file
+ */
+static std::vector<uint8_t> ReadFile(const std::string& name)
+{
+	std::ifstream file(name, std::ios::binary);
+
+	if (!file)
+	{
+		Fail("cannot open '%s'", name.c_str());
+	}
+
+	return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+/** @brief Write whole file
+ */
+static void WriteFile(const std::string& name, const void* data, size_t size)
+{
+	std::ofstream file(name, std::ios::binary);
+
+	if (!file || !file.write((const char*)data, size))
+	{
+		Fail("cannot write '%s'", name.c_str());
+	}
+}
+
+/** @brief Big-endian reader
+ */
+struct Reader
+{
+	const std::vector<uint8_t>& Data;
+	size_t Offset = 0;
+
+	void Need(size_t count)
+	{
+		if (this->Offset + count > this->Data.size())
+		{
+			Fail("unexpected end of file at offset %zu", this->Offset);
+		}
+	}
+
+	uint8_t U8()
+	{
+		this->Need(1);
+		return this->Data[this->Offset++];
+	}
+
+	uint16_t U16()
+	{
+		uint16_t high = this->U8();
+		return (high << 8) | this->U8();
+	}
+
+	uint32_t U32()
+	{
+		uint32_t high = this->U16();
+		return (high << 16) | this->U16();
+	}
+};
+
+/** @brief Big-endian writer
+ */
+struct Writer
+{
+	std::vector<uint8_t> Data;
+
+	void U8(uint8_t value) { this->Data.push_back(value); }
+	void U16(uint16_t value) { this->U8(value >> 8); this->U8(value & 0xff); }
+	void U32(uint32_t value) { this->U16(value >> 16); this->U16(value & 0xffff); }
+};
+
+/** @brief Decode UTE file
+ * @note Tile depth and rotation bit-fields are unpacked by hand, host bit-field order differs from SH-2
+ */
+static Level DecodeUte(const std::vector<uint8_t>& file)
+{
+	Level level;
+	Reader reader { file };
+	std::memset(&level.Data, 0, sizeof(level.Data));
+
+	for (unsigned char& byte : level.Data.Identifier) byte = reader.U8();
+
+	if (std::memcmp(level.Data.Identifier, "UTE", 3) != 0)
+	{
+		Fail("not an UTE file");
+	}
+
+	for (LevelFormat::Tile& tile : level.Data.TileData)
+	{
+		uint8_t packed = reader.U8();
+		tile.Rotation = packed >> 6;
+		tile.Depth = packed & 0x3f;
+		tile.Texture = reader.U8();
+		tile.Dummy = reader.U16();
+	}
+
+	level.Data.Sun.Direction.X = reader.U32();
+	level.Data.Sun.Direction.Y = reader.U32();
+	level.Data.Sun.Direction.Z = reader.U32();
+	level.Data.Sun.Color = reader.U16();
+	level.Data.Sun.Dummy = reader.U16();
+
+	for (LevelFormat::GouraudColor& gouraud : level.Data.Gouraud)
+	{
+		for (uint16_t& color : gouraud.Colors) color = reader.U16();
+	}
+
+	for (LevelFormat::Vector& normal : level.Data.Normals)
+	{
+		normal.X = reader.U32();
+		normal.Y = reader.U32();
+		normal.Z = reader.U32();
+	}
+
+	level.Data.EntityCount = reader.U32();
+
+	for (uint32_t index = 0; index < level.Data.EntityCount; index++)
+	{
+		LevelFormat::EntityDefinition entity;
+		entity.Type = reader.U32();
+		entity.TileX = reader.U16();
+		entity.TileY = reader.U16();
+		entity.Direction = reader.U32();
+
+		for (unsigned char& byte : entity.Dummy) byte = reader.U8();
+
+		level.Entities.push_back(entity);
+	}
+
+	if (reader.Offset != file.size())
+	{
+		std::fprintf(stderr, "utemap: warning: %zu trailing bytes ignored\n", file.size() - reader.Offset);
+	}
+
+	return level;
+}
+
+/** @brief Encode UTE file
+ */
+static std::vector<uint8_t> EncodeUte(const Level& level)
+{
+	Writer writer;
+
+	for (unsigned char byte : level.Data.Identifier) writer.U8(byte);
+
+	for (const LevelFormat::Tile& tile : level.Data.TileData)
+	{
+		writer.U8((tile.Rotation << 6) | tile.Depth);
+		writer.U8(tile.Texture);
+		writer.U16(tile.Dummy);
+	}
+
+	writer.U32(level.Data.Sun.Direction.X);
+	writer.U32(level.Data.Sun.Direction.Y);
+	writer.U32(level.Data.Sun.Direction.Z);
+	writer.U16(level.Data.Sun.Color);
+	writer.U16(level.Data.Sun.Dummy);
+
+	for (const LevelFormat::GouraudColor& gouraud : level.Data.Gouraud)
+	{
+		for (uint16_t color : gouraud.Colors) writer.U16(color);
+	}
+
+	for (const LevelFormat::Vector& normal : level.Data.Normals)
+	{
+		writer.U32(normal.X);
+		writer.U32(normal.Y);
+		writer.U32(normal.Z);
+	}
+
+	writer.U32(level.Entities.size());
+
+	for (const LevelFormat::EntityDefinition& entity : level.Entities)
+	{
+		writer.U32(entity.Type);
+		writer.U16(entity.TileX);
+		writer.U16(entity.TileY);
+		writer.U32(entity.Direction);
+
+		for (unsigned char byte : entity.Dummy) writer.U8(byte);
+	}
+
+	return writer.Data;
+}
+
+/*
+ * Level source
+ */
+
+/** @brief Write level source
+ */
+static std::string WriteSource(const Level& level)
+{
+	std::ostringstream out;
+	char line[256];
+	const int size = LevelFormat::MapDimensionSize;
+
+	out << "# UTE level source\n";
+	std::snprintf(line, sizeof(line), "identifier %c%c%c %d\n", level.Data.Identifier[0], level.Data.Identifier[1], level.Data.Identifier[2], level.Data.Identifier[3]);
+	out << line;
+
+	std::snprintf(
+		line,
+		sizeof(line),
+		"sun %.6f %.6f %.6f 0x%04x\n",
+		FromFixed(level.Data.Sun.Direction.X),
+		FromFixed(level.Data.Sun.Direction.Y),
+		FromFixed(level.Data.Sun.Direction.Z),
+		level.Data.Sun.Color);
+	out << line;
+
+	const char* grids[] = { "depth", "texture", "rotation" };
+
+	for (int grid = 0; grid < 3; grid++)
+	{
+		out << "\n" << grids[grid] << "\n";
+
+		for (int y = 0; y < size; y++)
+		{
+			for (int x = 0; x < size; x++)
+			{
+				const LevelFormat::Tile& tile = level.Data.TileData[GetTileIndex(x, y)];
+				int value = grid == 0 ? tile.Depth : (grid == 1 ? tile.Texture : tile.Rotation);
+				std::snprintf(line, sizeof(line), x == 0 ? "%2d" : " %2d", value);
+				out << line;
+			}
+
+			out << "\n";
+		}
+
+		out << "end\n";
+	}
+
+	out << "\n# Baked data, remove the blocks or compile with --rebake to recalculate\nnormals\n";
+
+	for (const LevelFormat::Vector& normal : level.Data.Normals)
+	{
+		std::snprintf(line, sizeof(line), "%.6f %.6f %.6f\n", FromFixed(normal.X), FromFixed(normal.Y), FromFixed(normal.Z));
+		out << line;
+	}
+
+	out << "end\n\ngouraud\n";
+
+	for (const LevelFormat::GouraudColor& gouraud : level.Data.Gouraud)
+	{
+		std::snprintf(line, sizeof(line), "0x%04x 0x%04x 0x%04x 0x%04x\n", gouraud.Colors[0], gouraud.Colors[1], gouraud.Colors[2], gouraud.Colors[3]);
+		out << line;
+	}
+
+	out << "end\n\n# entity <type> <tile x> <tile y> <direction> [data bytes]\n";
+
+	for (const LevelFormat::EntityDefinition& entity : level.Entities)
+	{
+		if (entity.Type >= 0 && entity.Type <= Crate)
+		{
+			out << "entity " << EntityTypeNames[entity.Type];
+		}
+		else
+		{
+			out << "entity " << entity.Type;
+		}
+
+		std::snprintf(line, sizeof(line), " %d %d %.6f", entity.TileX, entity.TileY, FromFixed(entity.Direction));
+		out << line;
+
+		// Trailing zero bytes are implied
+		int used = sizeof(entity.Dummy);
+
+		while (used > 0 && entity.Dummy[used - 1] == 0) used--;
+
+		for (int byte = 0; byte < used; byte++) out << " " << (int)entity.Dummy[byte];
+
+		out << "\n";
+	}
+
+	return out.str();
+}
+
+/** @brief Parse level source
+ * @param text Source text
+ * @param hasNormals Set when source contains baked normals
+ * @param hasGouraud Set when source contains baked gouraud table
+ */
+static Level ReadSource(const std::string& text, bool& hasNormals, bool& hasGouraud)
+{
+	Level level;
+	std::memset(&level.Data, 0, sizeof(level.Data));
+	std::memcpy(level.Data.Identifier, "UTE", 4);
+	level.Data.Sun.Color = 0xffff;
+	hasNormals = false;
+	hasGouraud = false;
+
+	std::istringstream in(text);
+	std::string line;
+	std::string block;
+	int row = 0;
+	int lineNumber = 0;
+
+	while (std::getline(in, line))
+	{
+		lineNumber++;
+		size_t comment = line.find('#');
+
+		if (comment != std::string::npos)
+		{
+			line.erase(comment);
+		}
+
+		std::istringstream words(line);
+		std::string keyword;
+
+		if (!(words >> keyword))
+		{
+			continue;
+		}
+
+		if (!block.empty())
+		{
+			if (keyword == "end")
+			{
+				int expected = block == "normals" || block == "gouraud" ? LevelFormat::TileCount : LevelFormat::MapDimensionSize;
+
+				if (row != expected)
+				{
+					Fail("line %d: block '%s' has %d rows, expected %d", lineNumber, block.c_str(), row, expected);
+				}
+
+				block.clear();
+				continue;
+			}
+
+			std::istringstream values(line);
+
+			if (row >= LevelFormat::TileCount || ((block == "depth" || block == "texture" || block == "rotation") && row >= LevelFormat::MapDimensionSize))
+			{
+				Fail("line %d: too many rows in '%s'", lineNumber, block.c_str());
+			}
+
+			if (block == "normals")
+			{
+				double x, y, z;
+
+				if (!(values >> x >> y >> z))
+				{
+					Fail("line %d: expected 3 numbers", lineNumber);
+				}
+
+				level.Data.Normals[row] = { ToFixed(x), ToFixed(y), ToFixed(z) };
+			}
+			else if (block == "gouraud")
+			{
+				for (uint16_t& color : level.Data.Gouraud[row].Colors)
+				{
+					std::string value;
+
+					if (!(values >> value))
+					{
+						Fail("line %d: expected 4 colors", lineNumber);
+					}
+
+					color = std::strtoul(value.c_str(), nullptr, 0);
+				}
+			}
+			else
+			{
+				for (int x = 0; x < LevelFormat::MapDimensionSize; x++)
+				{
+					int value;
+
+					if (!(values >> value))
+					{
+						Fail("line %d: expected %d numbers", lineNumber, LevelFormat::MapDimensionSize);
+					}
+
+					LevelFormat::Tile& tile = level.Data.TileData[GetTileIndex(x, row)];
+
+					if (block == "depth")
+					{
+						if (value < 0 || value > 63) Fail("line %d: depth %d out of range 0-63", lineNumber, value);
+						tile.Depth = value;
+					}
+					else if (block == "texture")
+					{
+						if (value < 0 || value > 255) Fail("line %d: texture %d out of range 0-255", lineNumber, value);
+						tile.Texture = value;
+					}
+					else
+					{
+						if (value < 0 || value > 3) Fail("line %d: rotation %d out of range 0-3", lineNumber, value);
+						tile.Rotation = value;
+					}
+				}
+			}
+
+			row++;
+		}
+		else if (keyword == "depth" || keyword == "texture" || keyword == "rotation" || keyword == "normals" || keyword == "gouraud")
+		{
+			block = keyword;
+			row = 0;
+			hasNormals |= keyword == "normals";
+			hasGouraud |= keyword == "gouraud";
+		}
+		else if (keyword == "identifier")
+		{
+			std::string name;
+			int version;
+
+			if (!(words >> name >> version) || name.size() != 3)
+			{
+				Fail("line %d: expected 'identifier UTE <version>'", lineNumber);
+			}
+
+			std::memcpy(level.Data.Identifier, name.c_str(), 3);
+			level.Data.Identifier[3] = version;
+		}
+		else if (keyword == "sun")
+		{
+			double x, y, z;
+			std::string color;
+
+			if (!(words >> x >> y >> z >> color))
+			{
+				Fail("line %d: expected 'sun <x> <y> <z> <color>'", lineNumber);
+			}
+
+			level.Data.Sun.Direction = { ToFixed(x), ToFixed(y), ToFixed(z) };
+			level.Data.Sun.Color = std::strtoul(color.c_str(), nullptr, 0);
+		}
+		else if (keyword == "entity")
+		{
+			LevelFormat::EntityDefinition entity;
+			std::memset(&entity, 0, sizeof(entity));
+
+			std::string type;
+			int tileX, tileY;
+			double direction;
+
+			if (!(words >> type >> tileX >> tileY >> direction))
+			{
+				Fail("line %d: expected 'entity <type> <tile x> <tile y> <direction>'", lineNumber);
+			}
+
+			entity.Type = -1;
+
+			for (int index = 0; index <= Crate; index++)
+			{
+				if (type == EntityTypeNames[index]) entity.Type = index;
+			}
+
+			if (entity.Type < 0)
+			{
+				entity.Type = std::strtol(type.c_str(), nullptr, 0);
+			}
+
+			if (tileX < 0 || tileX >= LevelFormat::MapDimensionSize || tileY < 0 || tileY >= LevelFormat::MapDimensionSize)
+			{
+				Fail("line %d: entity tile %d,%d is outside of the map", lineNumber, tileX, tileY);
+			}
+
+			entity.TileX = tileX;
+			entity.TileY = tileY;
+			entity.Direction = ToFixed(direction);
+
+			int value;
+			size_t byte = 0;
+
+			while (words >> value)
+			{
+				if (byte >= sizeof(entity.Dummy)) Fail("line %d: too many data bytes", lineNumber);
+				entity.Dummy[byte++] = value;
+			}
+
+			level.Entities.push_back(entity);
+		}
+		else
+		{
+			Fail("line %d: unknown keyword '%s'", lineNumber, keyword.c_str());
+		}
+	}
+
+	if (!block.empty())
+	{
+		Fail("block '%s' is missing 'end'", block.c_str());
+	}
+
+	level.Data.EntityCount = level.Entities.size();
+	return level;
+}
+
+/*
+ * Baking
+ */
+
+/** @brief Get vertex heights of the terrain mesh the same way Objects::Map builds it
+ * @param level Level data
+ * @param heights Result, (size + 1) * (size + 1) heights in world units
+ */
+static void GetVertexHeights(const Level& level, double* heights)
+{
+	const int size = LevelFormat::MapDimensionSize;
+
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			// Later tiles overwrite shared vertices, same as the game
+			heights[x + 1 + (y * (size + 1))] = GetDepth(level, x + 1, y + 1) / 4.0;
+			heights[x + 1 + ((y + 1) * (size + 1))] = GetDepth(level, x + 1, y) / 4.0;
+			heights[x + ((y + 1) * (size + 1))] = GetDepth(level, x, y + 1) / 4.0;
+			heights[x + (y * (size + 1))] = GetDepth(level, x, y) / 4.0;
+		}
+	}
+}
+
+/** @brief Get height of a vertex on the smoothed terrain the normals were baked from
+ * @details Baker averages depth of the four tiles sharing the vertex and scales it to half a unit per step
+ * @param level Level data
+ * @param x Vertex X coordinate
+ * @param y Vertex Y coordinate
+ * @return Height in world units
+ */
+static double GetSmoothHeight(const Level& level, int x, int y)
+{
+	int depth = GetDepth(level, x - 1, y - 1) + GetDepth(level, x, y - 1) + GetDepth(level, x - 1, y) + GetDepth(level, x, y);
+	return depth / 8.0;
+}
+
+/** @brief Get normal of a vertex on the smoothed terrain
+ * @details Central difference of neighbouring vertices, one sided on map edges
+ * @param level Level data
+ * @param x Vertex X coordinate
+ * @param y Vertex Y coordinate
+ * @return Unit normal
+ */
+static Vector GetSmoothNormal(const Level& level, int x, int y)
+{
+	const int size = LevelFormat::MapDimensionSize;
+	int left = std::max(x - 1, 0);
+	int right = std::min(x + 1, size);
+	int top = std::max(y - 1, 0);
+	int bottom = std::min(y + 1, size);
+
+	double slopeX = (GetSmoothHeight(level, right, y) - GetSmoothHeight(level, left, y)) / ((right - left) * 8.0);
+	double slopeY = (GetSmoothHeight(level, x, bottom) - GetSmoothHeight(level, x, top)) / ((bottom - top) * 8.0);
+	return Vector { -slopeX, -slopeY, 1.0 }.Normalized();
+}
+
+/** @brief Calculate tile normals from terrain geometry
+ * @details Sum of smoothed vertex normals at the tile corners, matches shipped maps within a fraction of a degree
+ * @param level Level data
+ * @param normals Result, one normal per tile
+ */
+static void GetGeometryNormals(const Level& level, Vector* normals)
+{
+	const int size = LevelFormat::MapDimensionSize;
+
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			Vector normal = GetSmoothNormal(level, x, y) + GetSmoothNormal(level, x + 1, y) +
+				GetSmoothNormal(level, x + 1, y + 1) + GetSmoothNormal(level, x, y + 1);
+			normals[GetTileIndex(x, y)] = normal.Normalized();
+		}
+	}
+}
+
+/** @brief Get light intensity of a vertex, same as Objects::Map::GetVertexLight
+ */
+static double GetVertexLight(const Level& level, int x, int y)
+{
+	Vector normal;
+
+	for (int tileY = y - 1; tileY <= y; tileY++)
+	{
+		for (int tileX = x - 1; tileX <= x; tileX++)
+		{
+			if (tileX >= 0 && tileX < LevelFormat::MapDimensionSize && tileY >= 0 && tileY < LevelFormat::MapDimensionSize)
+			{
+				const LevelFormat::Vector& tile = level.Data.Normals[GetTileIndex(tileX, tileY)];
+				normal = normal + Vector { FromFixed(tile.X), FromFixed(tile.Y), FromFixed(tile.Z) };
+			}
+		}
+	}
+
+	if (normal.Length() == 0.0)
+	{
+		return 0.0;
+	}
+
+	const LevelFormat::Vector& sun = level.Data.Sun.Direction;
+	double intensity = -Vector { FromFixed(sun.X), FromFixed(sun.Y), FromFixed(sun.Z) }.Dot(normal.Normalized());
+	return std::min(std::max(intensity, 0.0), 1.0);
+}
+
+/** @brief Get baked gouraud color of a tile corner
+ * @details File order is geometric and ignores tile rotation, the game maps it to rotated polygon
+ * corners on load (see Objects::Map::GetGouraudCorner)
+ * @param level Level data
+ * @param tile Tile index
+ * @param corner Corner in file order
+ */
+static uint16_t GetVertexColor(const Level& level, int tile, int corner)
+{
+	static const int offsets[4][2] = { { 0, 0 }, { 0, 1 }, { 1, 1 }, { 1, 0 } };
+	int x = (tile % LevelFormat::MapDimensionSize) + offsets[corner][0];
+	int y = (tile / LevelFormat::MapDimensionSize) + offsets[corner][1];
+
+	double intensity = GetVertexLight(level, x, y);
+	uint16_t sun = level.Data.Sun.Color;
+	int red = (int)((sun & 0x1f) * intensity);
+	int green = (int)(((sun >> 5) & 0x1f) * intensity);
+	int blue = (int)(((sun >> 10) & 0x1f) * intensity);
+	return 0x8000 | (blue << 10) | (green << 5) | red;
+}
+
+/** @brief Recalculate normals from geometry
+ */
+static void BakeNormals(Level& level)
+{
+	Vector normals[LevelFormat::TileCount];
+	GetGeometryNormals(level, normals);
+
+	for (int tile = 0; tile < LevelFormat::TileCount; tile++)
+	{
+		level.Data.Normals[tile] = { ToFixed(normals[tile].X), ToFixed(normals[tile].Y), ToFixed(normals[tile].Z) };
+	}
+}
+
+/** @brief Recalculate gouraud table from normals and sun
+ */
+static void BakeGouraud(Level& level)
+{
+	for (int tile = 0; tile < LevelFormat::TileCount; tile++)
+	{
+		for (int corner = 0; corner < 4; corner++)
+		{
+			level.Data.Gouraud[tile].Colors[corner] = GetVertexColor(level, tile, corner);
+		}
+	}
+}
+
+/** @brief Encode chunk pack, one sector per chunk ordered by chunk index
+ */
+static std::vector<uint8_t> EncodeChunks(const Level& level)
+{
+	const int size = LevelFormat::MapDimensionSize;
+	const int chunkSize = LevelFormat::ChunkSize;
+	std::vector<double> heights((size + 1) * (size + 1));
+	GetVertexHeights(level, heights.data());
+	Writer writer;
+
+	for (int chunk = 0; chunk < LevelFormat::ChunksPerSide * LevelFormat::ChunksPerSide; chunk++)
+	{
+		int firstX = (chunk % LevelFormat::ChunksPerSide) * chunkSize;
+		int firstY = (chunk / LevelFormat::ChunksPerSide) * chunkSize;
+		size_t start = writer.Data.size();
+
+		for (int y = 0; y < chunkSize; y++)
+		{
+			for (int x = 0; x < chunkSize; x++)
+			{
+				const LevelFormat::Tile& tile = level.Data.TileData[GetTileIndex(firstX + x, firstY + y)];
+				writer.U8((tile.Rotation << 6) | tile.Depth);
+				writer.U8(tile.Texture);
+				writer.U16(tile.Dummy);
+			}
+		}
+
+		for (int y = 0; y < chunkSize; y++)
+		{
+			for (int x = 0; x < chunkSize; x++)
+			{
+				const LevelFormat::Vector& normal = level.Data.Normals[GetTileIndex(firstX + x, firstY + y)];
+				writer.U32(normal.X);
+				writer.U32(normal.Y);
+				writer.U32(normal.Z);
+			}
+		}
+
+		for (int y = 0; y <= chunkSize; y++)
+		{
+			for (int x = 0; x <= chunkSize; x++)
+			{
+				writer.U32(ToFixed(heights[firstX + x + ((firstY + y) * (size + 1))]));
+			}
+		}
+
+		writer.Data.resize(start + LevelFormat::ChunkSectorSize, 0);
+	}
+
+	return writer.Data;
+}
+
+/*
+ * Checks
+ */
+
+/** @brief Get number of polygons in a NYA model
+ * @return Polygon count or -1 if model could not be read
+ */
+static int GetModelPolygons(const std::string& directory, int model)
+{
+	std::ifstream test(directory + "/" + ModelFiles[model], std::ios::binary);
+
+	if (!test)
+	{
+		return -1;
+	}
+
+	std::vector<uint8_t> file = ReadFile(directory + "/" + ModelFiles[model]);
+	Reader reader { file };
+	uint32_t meshCount = reader.U32();
+	uint32_t textureCount = reader.U32();
+	std::vector<int> meshPolygons;
+
+	for (uint32_t mesh = 0; mesh < meshCount; mesh++)
+	{
+		uint32_t points = reader.U32();
+		uint32_t count = reader.U32();
+
+		// POINT is 12 bytes, POLYGON is 20 bytes and face attribute is 8 bytes
+		reader.Offset += (points * 12) + (count * 28);
+		meshPolygons.push_back(count);
+	}
+
+	for (uint32_t texture = 0; texture < textureCount; texture++)
+	{
+		uint32_t width = reader.U16();
+		uint32_t height = reader.U16();
+		reader.Offset += width * height * 2;
+	}
+
+	// Lower detail levels are never drawn together with the mesh they replace
+	if (reader.Offset + 8 <= file.size() && file[reader.Offset] == 'L' && file[reader.Offset + 1] == 'O' && file[reader.Offset + 2] == 'D')
+	{
+		reader.Offset += 4;
+		uint32_t entries = reader.U32();
+
+		for (uint32_t entry = 0; entry < entries; entry++)
+		{
+			reader.U16();
+			uint16_t level = reader.U16();
+			reader.U32();
+
+			if (level < meshCount)
+			{
+				meshPolygons[level] = 0;
+			}
+		}
+	}
+
+	int polygons = 0;
+
+	for (int count : meshPolygons)
+	{
+		polygons += count;
+	}
+
+	return polygons;
+}
+
+/** @brief Verify level against budget
+ * @return Number of failed checks
+ */
+static int CheckLevel(const Level& level, const Budget& budget)
+{
+	int failed = 0;
+	auto report = [&](bool ok, const char* name, const char* format, auto... args)
+	{
+		std::printf("%-10s %s  ", name, ok ? "ok  " : "FAIL");
+		std::printf(format, args...);
+		std::printf("\n");
+		failed += ok ? 0 : 1;
+	};
+
+	// Baked normals
+	Vector geometry[LevelFormat::TileCount];
+	GetGeometryNormals(level, geometry);
+	double maxAngle = 0.0;
+	double totalAngle = 0.0;
+	int badNormals = 0;
+
+	for (int tile = 0; tile < LevelFormat::TileCount; tile++)
+	{
+		const LevelFormat::Vector& baked = level.Data.Normals[tile];
+		Vector normal { FromFixed(baked.X), FromFixed(baked.Y), FromFixed(baked.Z) };
+		double angle = std::acos(std::min(std::max(normal.Normalized().Dot(geometry[tile]), -1.0), 1.0)) * 180.0 / M_PI;
+
+		maxAngle = std::max(maxAngle, angle);
+		totalAngle += angle;
+
+		if (std::fabs(normal.Length() - 1.0) > 0.01 || normal.Z <= 0.0 || angle > budget.NormalTolerance)
+		{
+			if (badNormals++ < 5)
+			{
+				std::printf("  tile %d,%d normal %.4f %.4f %.4f is off by %.1f deg\n", tile % LevelFormat::MapDimensionSize, tile / LevelFormat::MapDimensionSize, normal.X, normal.Y, normal.Z, angle);
+			}
+		}
+	}
+
+	report(badNormals == 0, "normals", "%d bad, max %.1f deg, average %.1f deg from geometry", badNormals, maxAngle, totalAngle / LevelFormat::TileCount);
+
+	// Baked lighting
+	int maxDifference = 0;
+	int badColors = 0;
+
+	for (int tile = 0; tile < LevelFormat::TileCount; tile++)
+	{
+		for (int corner = 0; corner < 4; corner++)
+		{
+			uint16_t expected = GetVertexColor(level, tile, corner);
+			uint16_t baked = level.Data.Gouraud[tile].Colors[corner];
+			int difference = 0;
+
+			for (int shift = 0; shift < 15; shift += 5)
+			{
+				difference = std::max(difference, std::abs(((expected >> shift) & 0x1f) - ((baked >> shift) & 0x1f)));
+			}
+
+			maxDifference = std::max(maxDifference, difference);
+			badColors += difference > budget.LightTolerance ? 1 : 0;
+		}
+	}
+
+	report(badColors == 0, "lighting", "%d bad vertices, max channel difference %d", badColors, maxDifference);
+
+	// Entities
+	int counts[Crate + 1] = { 0 };
+	int handlers = 0;
+	int unknown = 0;
+	int outside = 0;
+
+	for (const LevelFormat::EntityDefinition& entity : level.Entities)
+	{
+		if (entity.TileX >= LevelFormat::MapDimensionSize || entity.TileY >= LevelFormat::MapDimensionSize)
+		{
+			outside++;
+		}
+
+		if (entity.Type >= 0 && entity.Type <= Crate)
+		{
+			counts[entity.Type]++;
+			handlers += HandlerSlots[entity.Type];
+		}
+		else
+		{
+			unknown++;
+		}
+	}
+
+	report(
+		unknown == 0 && outside == 0 && handlers <= budget.MaxHandlers,
+		"entities",
+		"%d players, %d models, %d crates, %d unknown, %d outside, %d/%d handler slots",
+		counts[PlayerSpawn],
+		counts[Model],
+		counts[Crate],
+		unknown,
+		outside,
+		handlers,
+		budget.MaxHandlers);
+
+	report(counts[PlayerSpawn] >= 2 && counts[PlayerSpawn] <= budget.MaxPlayers, "players", "%d/%d spawns, at least 2 needed", counts[PlayerSpawn], budget.MaxPlayers);
+
+	// Static colliders, game keeps only one collider per tile
+	bool used[LevelFormat::TileCount] = { false };
+	int colliders = 0;
+	int replaced = 0;
+
+	for (const LevelFormat::EntityDefinition& entity : level.Entities)
+	{
+		if (entity.Type == Model && entity.TileX < LevelFormat::MapDimensionSize && entity.TileY < LevelFormat::MapDimensionSize)
+		{
+			int tile = GetTileIndex(entity.TileX, entity.TileY);
+			colliders += used[tile] ? 0 : 1;
+			replaced += used[tile] ? 1 : 0;
+			used[tile] = true;
+		}
+	}
+
+	report(colliders <= budget.MaxColliders && replaced == 0, "colliders", "%d/%d tiles, %d replaced by another model", colliders, budget.MaxColliders, replaced);
+
+	// Polygons drawn when everything is visible
+	int polygons = LevelFormat::TileCount;
+	int missing = 0;
+	int modelPolygons[sizeof(ModelFiles) / sizeof(ModelFiles[0])];
+
+	for (size_t model = 0; model < sizeof(ModelFiles) / sizeof(ModelFiles[0]); model++)
+	{
+		modelPolygons[model] = GetModelPolygons(budget.ModelDirectory, model);
+	}
+
+	for (const LevelFormat::EntityDefinition& entity : level.Entities)
+	{
+		int model = entity.Type == Model ? entity.Dummy[1] : (entity.Type == Crate ? CrateModel : (entity.Type == PlayerSpawn ? PlayerModel : -1));
+
+		if (model < 0)
+		{
+			continue;
+		}
+
+		if (model >= (int)(sizeof(ModelFiles) / sizeof(ModelFiles[0])) || modelPolygons[model] < 0)
+		{
+			missing++;
+			continue;
+		}
+
+		polygons += modelPolygons[model];
+	}
+
+	report(polygons <= budget.MaxPolygons && missing == 0, "polygons", "%d/%d per frame, %d entities with unknown model", polygons, budget.MaxPolygons, missing);
+	return failed;
+}
+
+/*
+ * Commands
+ */
+
+/** @brief Parse budget option
+ * @return True if option was consumed
+ */
+static bool ParseBudgetOption(int argc, char** argv, int& index, Budget& budget)
+{
+	std::string option = argv[index];
+
+	if (index + 1 >= argc)
+	{
+		return false;
+	}
+
+	const char* value = argv[index + 1];
+
+	if (option == "--models") budget.ModelDirectory = value;
+	else if (option == "--max-polygons") budget.MaxPolygons = std::atoi(value);
+	else if (option == "--max-colliders") budget.MaxColliders = std::atoi(value);
+	else if (option == "--max-handlers") budget.MaxHandlers = std::atoi(value);
+	else if (option == "--max-players") budget.MaxPlayers = std::atoi(value);
+	else if (option == "--normal-tolerance") budget.NormalTolerance = std::atof(value);
+	else if (option == "--light-tolerance") budget.LightTolerance = std::atoi(value);
+	else return false;
+
+	index++;
+	return true;
+}
+
+/** @brief Print usage and exit
+ */
+[[noreturn]] static void Usage()
+{
+	std::fprintf(
+		stderr,
+		"usage: utemap decode <map.ute> [-o <map.txt>]\n"
+		"       utemap compile <map.txt> -o <map.ute> [--rebake] [--force] [budget options]\n"
+		"       utemap check <map.ute> [budget options]\n"
+		"       utemap pack <map.ute> -o <map.utc>\n"
+		"budget options: --models <dir> --max-polygons <n> --max-colliders <n> --max-handlers <n>\n"
+		"                --max-players <n> --normal-tolerance <deg> --light-tolerance <steps>\n");
+	std::exit(2);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		Usage();
+	}
+
+	std::string command = argv[1];
+	std::string input = argv[2];
+	std::string output;
+	Budget budget;
+	bool rebake = false;
+	bool force = false;
+
+	for (int index = 3; index < argc; index++)
+	{
+		std::string option = argv[index];
+
+		if (option == "-o" && index + 1 < argc) output = argv[++index];
+		else if (option == "--rebake") rebake = true;
+		else if (option == "--force") force = true;
+		else if (!ParseBudgetOption(argc, argv, index, budget)) Usage();
+	}
+
+	if (command == "decode")
+	{
+		std::string source = WriteSource(DecodeUte(ReadFile(input)));
+
+		if (output.empty())
+		{
+			std::fwrite(source.data(), 1, source.size(), stdout);
+		}
+		else
+		{
+			WriteFile(output, source.data(), source.size());
+		}
+
+		return 0;
+	}
+
+	if (command == "check")
+	{
+		std::printf("%s\n", input.c_str());
+		return CheckLevel(DecodeUte(ReadFile(input)), budget) == 0 ? 0 : 1;
+	}
+
+	if (command == "pack")
+	{
+		if (output.empty())
+		{
+			Usage();
+		}
+
+		std::vector<uint8_t> file = EncodeChunks(DecodeUte(ReadFile(input)));
+		WriteFile(output, file.data(), file.size());
+		return 0;
+	}
+
+	if (command == "compile")
+	{
+		if (output.empty())
+		{
+			Usage();
+		}
+
+		std::vector<uint8_t> text = ReadFile(input);
+		bool hasNormals;
+		bool hasGouraud;
+		Level level = ReadSource(std::string(text.begin(), text.end()), hasNormals, hasGouraud);
+
+		if (rebake || !hasNormals)
+		{
+			BakeNormals(level);
+		}
+
+		if (rebake || !hasNormals || !hasGouraud)
+		{
+			BakeGouraud(level);
+		}
+
+		std::printf("%s\n", input.c_str());
+
+		if (CheckLevel(level, budget) != 0 && !force)
+		{
+			Fail("map is over budget, not writing '%s' (use --force to write anyway)", output.c_str());
+		}
+
+		std::vector<uint8_t> file = EncodeUte(level);
+		WriteFile(output, file.data(), file.size());
+		return 0;
+	}
+
+	Usage();
+}